@@ -0,0 +1,86 @@
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "csv.hpp"
+
+using namespace csv;
+
+namespace {
+
+	std::string CreateInput(const std::size_t size_in_bytes) {
+		const auto path = (std::filesystem::temp_directory_path() / "csv_io_benchmark.csv").string();
+		std::ofstream file{path, std::ios::binary};
+		std::string line;
+
+		for (std::size_t i = 0, written = 0; written < size_in_bytes; ++i, written += line.size()) {
+			line = std::to_string(i) + ", " + std::to_string(i * 0.5) + ", " + std::to_string(i % 97) + ", true\n";
+			file << line;
+		}
+
+		return path;
+	}
+
+	std::size_t CountRecords(InputSource& source) {
+		RecordReader reader{source};
+		std::size_t count = 0;
+		for (std::string_view record; reader.Next(record);) {
+			++count;
+		}
+		return count;
+	}
+
+	void Measure(const std::string& name, const std::size_t size_in_bytes, const std::function<std::size_t()>& run) {
+		const auto start = std::chrono::steady_clock::now();
+		const auto records = run();
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		std::cout << std::left << std::setw(24) << name << std::right << std::setw(10) << records << " records "
+			<< std::fixed << std::setprecision(1) << std::setw(10) << size_in_bytes / elapsed.count() / (1 << 20) << " MiB/s" << std::endl;
+	}
+}
+
+int main(const int argc, const char* const argv[]) {
+	const std::size_t size_in_megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+	const std::size_t size_in_bytes = size_in_megabytes << 20;
+	const auto path = CreateInput(size_in_bytes);
+
+	// Records are split straight from the mapping, without copying them through a source's buffer.
+	Measure("mmap", size_in_bytes, [&] {
+		const MappedFile file{path};
+		const Tokenizer<CsvDialect> tokenizer{CsvDialect{}};
+		std::size_t count = 0;
+		std::size_t position = 0;
+		for (std::string_view record; tokenizer.NextRecord(file.Data(), position, record, true);) {
+			++count;
+		}
+		return count;
+	});
+
+	Measure("pread", size_in_bytes, [&] {
+		PreadSource source{path};
+		return CountRecords(source);
+	});
+
+#ifdef CSV_HAS_IO_URING
+	for (const auto direct : {false, true}) {
+		try {
+			Measure(direct ? "io_uring (O_DIRECT)" : "io_uring", size_in_bytes, [&] {
+				IoUringSource source{path, 1 << 20, 8, direct};
+				return CountRecords(source);
+			});
+		}
+		catch (const std::exception& e) {
+			std::cout << (direct ? "io_uring (O_DIRECT)" : "io_uring") << " unavailable: " << e.what() << std::endl;
+		}
+	}
+#endif
+
+	std::filesystem::remove(path);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,244 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "csv.hpp"
+
+using namespace csv;
+
+namespace {
+
+	std::atomic<std::size_t> allocation_count{0};
+}
+
+// Counts every heap allocation in the process so steady-state parsing can be checked to allocate nothing per row.
+void* operator new(const std::size_t size) {
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	if (auto* const memory = std::malloc(size == 0 ? 1 : size)) {
+		return memory;
+	}
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* const memory) noexcept { std::free(memory); }
+void operator delete(void* const memory, std::size_t) noexcept { std::free(memory); }
+
+namespace {
+
+	constexpr double kDefaultTolerance = 0.4;
+
+	struct Scenario {
+		std::string name;
+		std::function<std::size_t(std::string_view)> run;
+		std::string input;
+	};
+
+	struct Baseline {
+		double mib_per_second = 0;
+		double tolerance = kDefaultTolerance;
+	};
+
+	// Inputs are generated from the row index alone so every run parses identical bytes.
+	std::string CreateInput(const std::size_t size_in_bytes, const std::function<std::string(std::size_t)>& make_line) {
+		std::string data;
+		data.reserve(size_in_bytes + 128);
+		for (std::size_t i = 0; data.size() < size_in_bytes; ++i) {
+			data += make_line(i);
+		}
+		return data;
+	}
+
+	std::vector<Scenario> CreateScenarios(const std::size_t size_in_bytes) {
+		const auto numeric = CreateInput(size_in_bytes, [](const std::size_t i) {
+			return std::to_string(i) + "," + std::to_string(i * 0.25) + "," + std::to_string(i % 9973) + "," + (i % 3 == 0 ? "true" : "false") + "\n";
+		});
+		const auto strings = CreateInput(size_in_bytes, [](const std::size_t i) {
+			return std::to_string(i) + ",\"name " + std::to_string(i * 7919 % 100003) + "\",category" + std::to_string(i % 17) + "\n";
+		});
+		const auto nullable = CreateInput(size_in_bytes, [](const std::size_t i) {
+			return (i % 5 == 0 ? std::string{} : std::to_string(i)) + "," + (i % 7 == 0 ? std::string{} : std::to_string(i * 0.5)) + "\n";
+		});
+		const auto homogeneous = CreateInput(size_in_bytes, [](const std::size_t i) {
+			return std::to_string(i * 0.125) + "," + std::to_string(i * 0.5) + "," + std::to_string(i * 1.5) + "," + std::to_string(i * 2.0) + "\n";
+		});
+
+		return {
+			{"row_reader_numeric", [](const std::string_view data) {
+				BufferSource source{data};
+				RowReader<std::int64_t, double, std::int32_t, bool> reader{source};
+				std::tuple<std::int64_t, double, std::int32_t, bool> row;
+				std::size_t count = 0;
+				while (reader.Next(row)) {
+					++count;
+				}
+				return count;
+			}, numeric},
+			{"csv_numeric", [](const std::string_view data) {
+				return Csv<std::int64_t, double, std::int32_t, bool>{data}.RowCount();
+			}, numeric},
+			{"csv_strings", [](const std::string_view data) {
+				return Csv<std::int64_t, std::string, Dictionary>{data}.RowCount();
+			}, strings},
+			{"csv_strings_utf8", [](const std::string_view data) {
+				return BasicCsv<Utf8CsvDialect, std::int64_t, std::string, Dictionary>{data}.RowCount();
+			}, strings},
+			{"csv_nullable", [](const std::string_view data) {
+				return Csv<std::optional<std::int64_t>, std::optional<double>>{data}.RowCount();
+			}, nullable},
+			{"csv_homogeneous", [](const std::string_view data) { return Csv<double>{data}.RowCount(); }, homogeneous},
+		};
+	}
+
+	// The best of several runs, which is least disturbed by other load on the machine.
+	double MeasureThroughput(const Scenario& scenario, const int runs) {
+		double best = 0;
+		for (auto run = 0; run < runs; ++run) {
+			const auto start = std::chrono::steady_clock::now();
+			if (scenario.run(scenario.input) == 0) {
+				throw std::runtime_error{scenario.name + " parsed no rows"};
+			}
+			const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			best = std::max(best, scenario.input.size() / elapsed.count() / (1 << 20));
+		}
+		return best;
+	}
+
+	std::map<std::string, Baseline> LoadBaseline(const std::string& path) {
+		std::ifstream file{path};
+		if (!file) {
+			throw std::runtime_error{"Unable to open " + path};
+		}
+
+		std::map<std::string, Baseline> baseline;
+		for (std::string line; std::getline(file, line);) {
+			if (line.empty() || line.front() == '#') {
+				continue;
+			}
+			std::istringstream fields{line};
+			std::string name;
+			Baseline entry;
+			if (!(fields >> name >> entry.mib_per_second >> entry.tolerance)) {
+				throw std::runtime_error{"Invalid baseline entry: " + line};
+			}
+			baseline[name] = entry;
+		}
+		return baseline;
+	}
+
+	void SaveBaseline(const std::string& path, const std::map<std::string, Baseline>& baseline) {
+		std::ofstream file{path};
+		file << "# Parse throughput in MiB/s measured by csv_parse_benchmark in an optimized build, and the fraction by which\n"
+			<< "# each scenario may fall below it before the performance test fails. Regenerate with --update.\n";
+		for (const auto& [name, entry] : baseline) {
+			file << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(1) << std::setw(10)
+				<< entry.mib_per_second << std::setprecision(2) << std::setw(8) << entry.tolerance << '\n';
+		}
+	}
+
+	// Fixed-width numeric rows are parsed in place, so once the read buffer and field list have grown no row allocates.
+	bool CheckRowReaderAllocations(const std::string_view data) {
+		constexpr std::size_t kWarmupRows = 1024;
+
+		BufferSource source{data};
+		RowReader<std::int64_t, double, std::int32_t, bool> reader{source};
+		std::tuple<std::int64_t, double, std::int32_t, bool> row;
+		std::size_t count = 0;
+		while (count < kWarmupRows && reader.Next(row)) {
+			++count;
+		}
+
+		const auto allocations = allocation_count.load();
+		while (reader.Next(row)) {
+			++count;
+		}
+		const auto steady_allocations = allocation_count.load() - allocations;
+
+		std::cout << "row_reader_numeric: " << steady_allocations << " allocations in " << count - kWarmupRows << " steady-state rows" << std::endl;
+		return steady_allocations == 0;
+	}
+
+	// Columns grow geometrically, so a table of numeric columns allocates a number of times logarithmic in its rows.
+	bool CheckTableAllocations(const std::string_view data) {
+		const auto allocations = allocation_count.load();
+		const auto rows = Csv<std::int64_t, double, std::int32_t, bool>{data}.RowCount();
+		const auto table_allocations = allocation_count.load() - allocations;
+
+		std::cout << "csv_numeric: " << table_allocations << " allocations for " << rows << " rows" << std::endl;
+		return table_allocations * 1000 < rows;
+	}
+}
+
+// Usage: csv_parse_benchmark [--baseline FILE] [--update] [--size MIB]
+// With a baseline, fails when a scenario's throughput falls below its band. Throughput is only compared in optimized
+// builds, while the allocation checks always run.
+int main(const int argc, const char* const argv[]) {
+	std::string baseline_path;
+	auto update = false;
+	std::size_t size_in_megabytes = 8;
+	for (auto i = 1; i < argc; ++i) {
+		const std::string_view argument{argv[i]};
+		if (argument == "--baseline" && i + 1 < argc) {
+			baseline_path = argv[++i];
+		}
+		else if (argument == "--update") {
+			update = true;
+		}
+		else if (argument == "--size" && i + 1 < argc) {
+			size_in_megabytes = std::strtoul(argv[++i], nullptr, 10);
+		}
+		else {
+			std::cerr << "Usage: " << argv[0] << " [--baseline FILE] [--update] [--size MIB]" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	const auto scenarios = CreateScenarios(size_in_megabytes << 20);
+	auto passed = CheckRowReaderAllocations(scenarios[0].input);
+	passed = CheckTableAllocations(scenarios[0].input) && passed;
+
+	// Updating keeps the tolerance of each scenario already in the baseline.
+	auto baseline = baseline_path.empty() || (update && !std::filesystem::exists(baseline_path)) ? std::map<std::string, Baseline>{}
+		: LoadBaseline(baseline_path);
+#ifdef NDEBUG
+	constexpr auto kCompareThroughput = true;
+#else
+	constexpr auto kCompareThroughput = false;
+	if (!baseline.empty()) {
+		std::cout << "Throughput is not compared against the baseline in unoptimized builds" << std::endl;
+	}
+#endif
+
+	for (const auto& scenario : scenarios) {
+		const auto throughput = MeasureThroughput(scenario, 3);
+		std::cout << std::left << std::setw(24) << scenario.name << std::right << std::fixed << std::setprecision(1) << std::setw(10)
+			<< throughput << " MiB/s";
+
+		if (update) {
+			baseline[scenario.name].mib_per_second = throughput;
+		}
+		else if (const auto entry = baseline.find(scenario.name); kCompareThroughput && entry != baseline.end()) {
+			const auto minimum = entry->second.mib_per_second * (1 - entry->second.tolerance);
+			std::cout << " (baseline " << entry->second.mib_per_second << ", minimum " << minimum << ")";
+			if (throughput < minimum) {
+				std::cout << " REGRESSED";
+				passed = false;
+			}
+		}
+		std::cout << std::endl;
+	}
+
+	if (update && !baseline_path.empty()) {
+		SaveBaseline(baseline_path, baseline);
+	}
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
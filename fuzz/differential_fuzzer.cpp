@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "csv.hpp"
+
+using namespace csv;
+
+namespace {
+
+	constexpr std::size_t kColumnCount = 3;
+
+	using Fields = std::array<std::string, kColumnCount>;
+
+	// Typed rows hold doubles by their bits so results are compared exactly, NaN payloads and signed zeros included.
+	struct TypedRow {
+		std::optional<std::int64_t> integer;
+		std::optional<std::uint64_t> real;
+		std::optional<bool> boolean;
+
+		friend bool operator==(const TypedRow& lhs, const TypedRow& rhs) {
+			return lhs.integer == rhs.integer && lhs.real == rhs.real && lhs.boolean == rhs.boolean;
+		}
+	};
+
+	// A parse either yields rows or fails; only whether it failed is compared since engines may report different rows.
+	template <typename Row> struct Outcome {
+		std::vector<Row> rows;
+		bool failed = false;
+
+		friend bool operator==(const Outcome& lhs, const Outcome& rhs) { return lhs.failed == rhs.failed && (lhs.failed || lhs.rows == rhs.rows); }
+	};
+
+	template <typename Row, typename Parse> Outcome<Row> Run(const Parse& parse) {
+		Outcome<Row> outcome;
+		try {
+			parse(outcome.rows);
+		}
+		catch (const std::exception&) {
+			outcome.rows.clear();
+			outcome.failed = true;
+		}
+		return outcome;
+	}
+
+	std::uint64_t Bits(const double value) {
+		std::uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	std::optional<std::uint64_t> Bits(const std::optional<double> value) {
+		return value ? std::optional<std::uint64_t>{Bits(*value)} : std::nullopt;
+	}
+
+	template <typename Row> void Expect(const char* const engine, const Outcome<Row>& reference, const Outcome<Row>& actual) {
+		if (!(reference == actual)) {
+			std::cerr << engine << " differs from the reference: " << actual.rows.size() << " rows" << (actual.failed ? " (failed)" : "")
+				<< " instead of " << reference.rows.size() << (reference.failed ? " (failed)" : "") << std::endl;
+			std::abort();
+		}
+	}
+
+	// The reference splits records with the runtime tokenizer, which has no dialect values folded into its scanning code.
+	Outcome<Fields> ReferenceFields(const std::string_view data, const RuntimeDialect& dialect) {
+		return Run<Fields>([&](std::vector<Fields>& rows) {
+			Tokenizer<RuntimeDialect> tokenizer{dialect};
+			std::size_t position = 0;
+			for (std::string_view record; tokenizer.NextRecord(data, position, record, true);) {
+				const auto& fields = tokenizer.Split(record);
+				auto& row = rows.emplace_back();
+				for (std::size_t i = 0; i < kColumnCount && i < fields.size(); ++i) {
+					row[i] = std::string{fields[i]};
+				}
+			}
+		});
+	}
+
+	template <typename Table> std::vector<Fields> TableFields(const Table& csv) {
+		std::vector<Fields> rows;
+		for (std::size_t row = 0; row < csv.RowCount(); ++row) {
+			auto& fields = rows.emplace_back();
+			for (std::size_t column = 0; column < kColumnCount; ++column) {
+				fields[column] = std::string{csv.template Get<std::string>(row, column)};
+			}
+		}
+		return rows;
+	}
+
+	template <typename DialectType> void CheckFields(const std::string_view data, const RuntimeDialect& runtime_dialect, const std::size_t chunk_size) {
+		using Table = BasicCsv<DialectType, std::string, std::string, std::string>;
+		// Tables skip a byte order mark at the start of their input, whereas the tokenizer and Append see only records.
+		const auto text = HasUtf8Bom(data) ? data.substr(kUtf8Bom.size()) : data;
+		const auto reference = ReferenceFields(text, runtime_dialect);
+
+		Expect("Compile-time dialect", reference, Run<Fields>([&](std::vector<Fields>& rows) { rows = TableFields(Table{data}); }));
+
+		Expect("Chunked reads", reference, Run<Fields>([&](std::vector<Fields>& rows) {
+			BufferSource source{data};
+			BasicRowReader<DialectType, std::string, std::string, std::string> reader{source, chunk_size};
+			for (std::tuple<std::string, std::string, std::string> row; reader.Next(row);) {
+				rows.push_back({std::get<0>(row), std::get<1>(row), std::get<2>(row)});
+			}
+		}));
+
+		Expect("Streaming appends", reference, Run<Fields>([&](std::vector<Fields>& rows) {
+			Table csv{std::string_view{}};
+			std::string pending;
+			for (std::size_t offset = 0; offset < text.size(); offset += chunk_size) {
+				pending.append(text.substr(offset, chunk_size));
+				pending.erase(0, csv.Append(pending, false));
+			}
+			csv.Append(pending, true);
+			rows = TableFields(csv);
+		}));
+	}
+
+	template <typename DialectType> void CheckTypes(const std::string_view data, const RuntimeDialect& runtime_dialect, const std::size_t chunk_size) {
+		Schema schema;
+		schema.dialect = runtime_dialect;
+		schema.columns = {{"integer", ColumnType::kInt64, true}, {"real", ColumnType::kDouble, true}, {"boolean", ColumnType::kBool, true}};
+
+		const auto reference = Run<TypedRow>([&](std::vector<TypedRow>& rows) {
+			const DynamicCsv csv{data, schema};
+			for (std::size_t row = 0; row < csv.RowCount(); ++row) {
+				rows.push_back({csv.Get<std::int64_t>(row, 0), Bits(csv.Get<double>(row, 1)), csv.Get<bool>(row, 2)});
+			}
+		});
+
+		Expect("Compile-time typed parse", reference, Run<TypedRow>([&](std::vector<TypedRow>& rows) {
+			const BasicCsv<DialectType, std::optional<std::int64_t>, std::optional<double>, std::optional<bool>> csv{data};
+			for (std::size_t row = 0; row < csv.RowCount(); ++row) {
+				const auto values = csv[row];
+				rows.push_back({values.template Get<0>(), Bits(values.template Get<1>()), values.template Get<2>()});
+			}
+		}));
+
+		Expect("Chunked typed reads", reference, Run<TypedRow>([&](std::vector<TypedRow>& rows) {
+			BufferSource source{data};
+			BasicRowReader<DialectType, std::optional<std::int64_t>, std::optional<double>, std::optional<bool>> reader{source, chunk_size};
+			for (std::tuple<std::optional<std::int64_t>, std::optional<double>, std::optional<bool>> row; reader.Next(row);) {
+				rows.push_back({std::get<0>(row), Bits(std::get<1>(row)), std::get<2>(row)});
+			}
+		}));
+	}
+
+	template <typename DialectType> void Check(const std::string_view data, const std::size_t chunk_size) {
+		const RuntimeDialect runtime_dialect{
+			DialectType::delimiter, DialectType::quote, DialectType::escape, DialectType::trim, DialectType::line_ending, DialectType::validate_utf8};
+		CheckFields<DialectType>(data, runtime_dialect, chunk_size);
+		CheckTypes<DialectType>(data, runtime_dialect, chunk_size);
+	}
+}
+
+// The first byte selects the dialect and the second the chunk size used by the chunked and streaming engines.
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* const data, const std::size_t size) {
+	if (size < 2) {
+		return 0;
+	}
+	const std::string_view input{reinterpret_cast<const char*>(data) + 2, size - 2};
+	const std::size_t chunk_size = data[1] % 64 + 1;
+
+	switch (data[0] % 5) {
+		case 0: Check<CsvDialect>(input, chunk_size); break;
+		case 1: Check<Dialect<',', '"', '"', true, LineEnding::kCrLf>>(input, chunk_size); break;
+		case 2: Check<Dialect<',', '\0'>>(input, chunk_size); break;
+		case 3: Check<Dialect<';', '"', '\\', false, LineEnding::kAny>>(input, chunk_size); break;
+		default: Check<Utf8CsvDialect>(input, chunk_size); break;
+	}
+	return 0;
+}
+
+#ifndef CSV_LIBFUZZER
+
+// Replays corpus files, or every file in corpus directories, when built without libFuzzer.
+int main(const int argc, const char* const argv[]) {
+	std::vector<std::filesystem::path> paths;
+	for (auto i = 1; i < argc; ++i) {
+		if (std::filesystem::is_directory(argv[i])) {
+			std::copy(std::filesystem::directory_iterator{argv[i]}, std::filesystem::directory_iterator{}, std::back_inserter(paths));
+		}
+		else {
+			paths.emplace_back(argv[i]);
+		}
+	}
+	std::sort(paths.begin(), paths.end());
+
+	for (const auto& path : paths) {
+		std::ifstream file{path, std::ios::binary};
+		const std::string input{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+		LLVMFuzzerTestOneInput(reinterpret_cast<const std::uint8_t*>(input.data()), input.size());
+	}
+
+	std::cout << paths.size() << " inputs matched the reference" << std::endl;
+	return paths.empty() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#endif
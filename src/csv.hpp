@@ -1,148 +1,4614 @@
 #pragma once
 
 #include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
+#include <string>
 #include <string_view>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
 #include <vector>
 
+#if __has_include(<bit>)
+#include <bit>
+#endif
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define CSV_HAS_COROUTINES 1
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CSV_HAS_POSIX_IO 1
+#endif
+
+#ifdef CSV_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef CSV_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>) && !defined(CSV_DISABLE_IO_URING)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#define CSV_HAS_IO_URING 1
+#endif
+
+#if defined(__linux__) && __has_include(<sys/inotify.h>)
+#include <poll.h>
+#include <sys/inotify.h>
+#define CSV_HAS_INOTIFY 1
+#endif
+
+// The Arrow C data interface (https://arrow.apache.org/docs/format/CDataInterface.html), declared as the specification
+// requires so that it may be shared with other headers which declare it.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+	const char* format;
+	const char* name;
+	const char* metadata;
+	int64_t flags;
+	int64_t n_children;
+	struct ArrowSchema** children;
+	struct ArrowSchema* dictionary;
+	void (*release)(struct ArrowSchema*);
+	void* private_data;
+};
+
+struct ArrowArray {
+	int64_t length;
+	int64_t null_count;
+	int64_t offset;
+	int64_t n_buffers;
+	int64_t n_children;
+	const void** buffers;
+	struct ArrowArray** children;
+	struct ArrowArray* dictionary;
+	void (*release)(struct ArrowArray*);
+	void* private_data;
+};
+
+#endif
+
 namespace csv {
 
-	class CsvBase {
+	template <typename T> class Span {
+
+	public:
+		using element_type = T;
+		using value_type = std::remove_cv_t<T>;
+		using size_type = std::size_t;
+		using reference = T&;
+		using iterator = T*;
+
+		constexpr Span() noexcept = default;
+		constexpr Span(T* const data, const std::size_t size) noexcept : data_{data}, size_{size} {}
+
+		[[nodiscard]] constexpr T* data() const noexcept { return data_; }
+		[[nodiscard]] constexpr std::size_t size() const noexcept { return size_; }
+		[[nodiscard]] constexpr bool empty() const noexcept { return size_ == 0; }
+		[[nodiscard]] constexpr T* begin() const noexcept { return data_; }
+		[[nodiscard]] constexpr T* end() const noexcept { return data_ + size_; }
+		[[nodiscard]] constexpr T& operator[](const std::size_t index) const noexcept { return data_[index]; }
+
+		[[nodiscard]] Span Subspan(const std::size_t offset, const std::size_t count) const {
+			if (offset > size_ || count > size_ - offset) {
+				throw std::runtime_error{"Index out of bounds"};
+			}
+			return {data_ + offset, count};
+		}
+
+	private:
+		T* data_ = nullptr;
+		std::size_t size_ = 0;
+	};
+
+	[[nodiscard]] inline std::size_t PopCount(const std::uint64_t word) noexcept {
+#if defined(__cpp_lib_bitops)
+		return static_cast<std::size_t>(std::popcount(word));
+#elif defined(__GNUC__) || defined(__clang__)
+		return static_cast<std::size_t>(__builtin_popcountll(word));
+#else
+		auto bits = word - ((word >> 1) & 0x5555555555555555);
+		bits = (bits & 0x3333333333333333) + ((bits >> 2) & 0x3333333333333333);
+		return static_cast<std::size_t>((((bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0F) * 0x0101010101010101) >> 56);
+#endif
+	}
+
+	[[nodiscard]] inline std::size_t CountTrailingZeros(const std::uint64_t word) noexcept {
+#if defined(__cpp_lib_bitops)
+		return static_cast<std::size_t>(std::countr_zero(word));
+#elif defined(__GNUC__) || defined(__clang__)
+		return word == 0 ? 64 : static_cast<std::size_t>(__builtin_ctzll(word));
+#else
+		std::size_t count = 0;
+		for (auto bits = word; count < 64 && (bits & 1) == 0; bits >>= 1) {
+			++count;
+		}
+		return count;
+#endif
+	}
+
+	// A packed sequence of bits stored least significant bit first within each 64-bit word.
+	class BitVector {
+
+	public:
+		using Word = std::uint64_t;
+		static constexpr std::size_t kWordBits = 64;
+
+		BitVector() noexcept = default;
+		BitVector(const std::size_t size, const bool value) : words_((size + kWordBits - 1) / kWordBits, value ? ~Word{0} : 0), size_{size} {
+			if (value && size % kWordBits != 0) {
+				words_.back() &= (Word{1} << (size % kWordBits)) - 1;
+			}
+		}
+
+		void push_back(const bool value) {
+			if (size_ % kWordBits == 0) {
+				words_.push_back(0);
+			}
+			words_.back() |= Word{value} << (size_ % kWordBits);
+			++size_;
+		}
+
+		void reserve(const std::size_t size) { words_.reserve((size + kWordBits - 1) / kWordBits); }
+
+		// Drops the bits from size onwards.
+		void Truncate(const std::size_t size) {
+			words_.resize((size + kWordBits - 1) / kWordBits);
+			if (size % kWordBits != 0) {
+				words_.back() &= (Word{1} << (size % kWordBits)) - 1;
+			}
+			size_ = size;
+		}
+
+		[[nodiscard]] bool operator[](const std::size_t index) const noexcept {
+			return (words_[index / kWordBits] >> (index % kWordBits)) & 1;
+		}
+
+		[[nodiscard]] std::size_t size() const noexcept { return size_; }
+		[[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+		[[nodiscard]] std::size_t MemoryUsage() const noexcept { return words_.capacity() * sizeof(Word); }
+
+		// Bits past size() in the last word are always zero.
+		[[nodiscard]] Span<const Word> Words() const noexcept { return {words_.data(), words_.size()}; }
+
+		[[nodiscard]] std::size_t Count() const noexcept {
+			std::size_t count = 0;
+			for (const auto word : words_) {
+				count += PopCount(word);
+			}
+			return count;
+		}
+
+		// Invokes callback with the index of each set bit in ascending order.
+		template <typename Callback> void ForEachSet(Callback&& callback) const {
+			for (std::size_t i = 0; i < words_.size(); ++i) {
+				for (auto word = words_[i]; word != 0; word &= word - 1) {
+					callback(i * kWordBits + CountTrailingZeros(word));
+				}
+			}
+		}
+
+		BitVector& operator&=(const BitVector& other) {
+			CheckSize(other);
+			std::transform(words_.begin(), words_.end(), other.words_.begin(), words_.begin(), std::bit_and<Word>{});
+			return *this;
+		}
+
+		BitVector& operator|=(const BitVector& other) {
+			CheckSize(other);
+			std::transform(words_.begin(), words_.end(), other.words_.begin(), words_.begin(), std::bit_or<Word>{});
+			return *this;
+		}
+
+		[[nodiscard]] friend BitVector operator&(BitVector lhs, const BitVector& rhs) { return lhs &= rhs; }
+		[[nodiscard]] friend BitVector operator|(BitVector lhs, const BitVector& rhs) { return lhs |= rhs; }
+
+	private:
+		void CheckSize(const BitVector& other) const {
+			if (size_ != other.size_) {
+				throw std::runtime_error{"Bit vector size mismatch"};
+			}
+		}
+
+		std::vector<Word> words_;
+		std::size_t size_ = 0;
+	};
+
+	template <typename T> struct ColumnTraits {
+		using Storage = std::vector<T>;
+		using View = Span<const T>;
+		using Reference = const T&;
+
+		static View MakeView(const Storage& storage) { return {storage.data(), storage.size()}; }
+	};
+
+	template <> struct ColumnTraits<bool> {
+		using Storage = BitVector;
+		using View = const BitVector&;
+		using Reference = bool;
+
+		static View MakeView(const Storage& storage) { return storage; }
+	};
+
+	// Stores strings back to back in one byte buffer delimited by offsets, so a column costs two allocations rather than
+	// one per string and matches Arrow's large string layout.
+	class StringColumn {
+
+	public:
+		void push_back(const std::string_view value) {
+			bytes_.insert(bytes_.end(), value.begin(), value.end());
+			offsets_.push_back(static_cast<std::int64_t>(bytes_.size()));
+		}
+
+		void reserve(const std::size_t size) { offsets_.reserve(size + 1); }
+
+		void Truncate(const std::size_t size) {
+			offsets_.resize(size + 1);
+			bytes_.resize(static_cast<std::size_t>(offsets_.back()));
+		}
+
+		[[nodiscard]] std::string_view operator[](const std::size_t index) const noexcept {
+			return {bytes_.data() + offsets_[index], static_cast<std::size_t>(offsets_[index + 1] - offsets_[index])};
+		}
+
+		[[nodiscard]] std::size_t size() const noexcept { return offsets_.size() - 1; }
+		[[nodiscard]] std::size_t MemoryUsage() const noexcept { return bytes_.capacity() + offsets_.capacity() * sizeof(std::int64_t); }
+
+		// String i spans [ValueOffsets()[i], ValueOffsets()[i + 1]) of ValueBytes().
+		[[nodiscard]] Span<const std::int64_t> ValueOffsets() const noexcept { return {offsets_.data(), offsets_.size()}; }
+		[[nodiscard]] Span<const char> ValueBytes() const noexcept { return {bytes_.data(), bytes_.size()}; }
+
+	private:
+		std::vector<char> bytes_;
+		std::vector<std::int64_t> offsets_{0};
+	};
+
+	template <> struct ColumnTraits<std::string> {
+		using Storage = StringColumn;
+		using View = const StringColumn&;
+		using Reference = std::string_view;
+
+		static View MakeView(const Storage& storage) { return storage; }
+	};
+
+	// A calendar date stored as the number of days since 1970-01-01 and written as YYYY-MM-DD.
+	struct Date {
+		std::int32_t days_since_epoch = 0;
+
+		[[nodiscard]] static constexpr Date FromCivil(const std::int32_t year, const unsigned month, const unsigned day) noexcept {
+			const auto shifted_year = year - (month <= 2 ? 1 : 0);
+			const auto era = (shifted_year >= 0 ? shifted_year : shifted_year - 399) / 400;
+			const auto year_of_era = static_cast<unsigned>(shifted_year - era * 400);
+			const auto day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+			const auto day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+			return Date{era * 146097 + static_cast<std::int32_t>(day_of_era) - 719468};
+		}
+
+		[[nodiscard]] friend constexpr bool operator==(const Date lhs, const Date rhs) noexcept { return lhs.days_since_epoch == rhs.days_since_epoch; }
+		[[nodiscard]] friend constexpr bool operator!=(const Date lhs, const Date rhs) noexcept { return lhs.days_since_epoch != rhs.days_since_epoch; }
+		[[nodiscard]] friend constexpr bool operator<(const Date lhs, const Date rhs) noexcept { return lhs.days_since_epoch < rhs.days_since_epoch; }
+		[[nodiscard]] friend constexpr bool operator>(const Date lhs, const Date rhs) noexcept { return lhs.days_since_epoch > rhs.days_since_epoch; }
+		[[nodiscard]] friend constexpr bool operator<=(const Date lhs, const Date rhs) noexcept { return lhs.days_since_epoch <= rhs.days_since_epoch; }
+		[[nodiscard]] friend constexpr bool operator>=(const Date lhs, const Date rhs) noexcept { return lhs.days_since_epoch >= rhs.days_since_epoch; }
+	};
+
+#if defined(__SIZEOF_INT128__)
+	__extension__ typedef __int128 Int128;
+
+	// Decimals of up to 38 digits are stored in 128 bits.
+	constexpr unsigned kMaxDecimalPrecision = 38;
+#else
+	constexpr unsigned kMaxDecimalPrecision = 18;
+#endif
+
+	// An exact fixed-point number of at most Precision digits, Scale of them after the decimal point, stored as an
+	// integer count of units of 10^-Scale. Up to 18 digits are stored in 64 bits and wider decimals in 128 bits.
+	template <unsigned Precision, unsigned Scale> struct Decimal {
+		static_assert(Precision >= 1 && Precision <= kMaxDecimalPrecision, "Decimal precision is out of range");
+		static_assert(Scale <= Precision, "Decimal scale exceeds its precision");
+
+#if defined(__SIZEOF_INT128__)
+		using Units = std::conditional_t<(Precision <= 18), std::int64_t, Int128>;
+#else
+		using Units = std::int64_t;
+#endif
+
+		static constexpr unsigned precision = Precision;
+		static constexpr unsigned scale = Scale;
+
+		Units units = 0;
+
+		// Parses [+-]digits[.digits] with integer arithmetic alone. Fractional digits beyond Scale must be zeros, so
+		// every accepted value is represented exactly, and values with more than Precision digits are rejected.
+		[[nodiscard]] static constexpr std::optional<Decimal> Parse(const std::string_view token) noexcept {
+			std::size_t index = 0;
+			const auto negative = !token.empty() && token.front() == '-';
+			if (!token.empty() && (token.front() == '-' || token.front() == '+')) {
+				++index;
+			}
+
+			Units magnitude = 0;
+			unsigned digits = 0;
+			unsigned fraction_digits = 0;
+			auto point = false;
+			auto any_digit = false;
+			for (; index < token.size(); ++index) {
+				const auto c = token[index];
+				if (c == '.' && !point) {
+					point = true;
+					continue;
+				}
+				if (c < '0' || c > '9') {
+					return std::nullopt;
+				}
+				any_digit = true;
+				if (point && fraction_digits == Scale) {
+					if (c != '0') {
+						return std::nullopt;
+					}
+					continue;
+				}
+				if (!point && magnitude == 0 && c == '0') {
+					continue;
+				}
+				if (++digits > Precision) {
+					return std::nullopt;
+				}
+				magnitude = magnitude * 10 + (c - '0');
+				fraction_digits += point ? 1 : 0;
+			}
+			if (!any_digit) {
+				return std::nullopt;
+			}
+
+			for (; fraction_digits < Scale; ++fraction_digits) {
+				if (++digits > Precision) {
+					return std::nullopt;
+				}
+				magnitude *= 10;
+			}
+			return Decimal{negative ? -magnitude : magnitude};
+		}
+
+		// The shortest form that parses back to the same value with every one of its Scale fractional digits.
+		[[nodiscard]] std::string ToString() const {
+			char digits[kMaxDecimalPrecision + 3];
+			auto* position = std::end(digits);
+			auto magnitude = units < 0 ? -units : units;
+			for (unsigned written = 0; magnitude != 0 || written <= Scale; ++written) {
+				if (written == Scale && Scale != 0) {
+					*--position = '.';
+				}
+				*--position = static_cast<char>('0' + static_cast<int>(magnitude % 10));
+				magnitude /= 10;
+			}
+			if (units < 0) {
+				*--position = '-';
+			}
+			return std::string{position, std::end(digits)};
+		}
+
+		[[nodiscard]] explicit operator double() const noexcept {
+			double power = 1;
+			for (unsigned i = 0; i < Scale; ++i) {
+				power *= 10;
+			}
+			return static_cast<double>(units) / power;
+		}
+
+		friend std::ostream& operator<<(std::ostream& stream, const Decimal value) { return stream << value.ToString(); }
+
+		[[nodiscard]] friend constexpr bool operator==(const Decimal lhs, const Decimal rhs) noexcept { return lhs.units == rhs.units; }
+		[[nodiscard]] friend constexpr bool operator!=(const Decimal lhs, const Decimal rhs) noexcept { return lhs.units != rhs.units; }
+		[[nodiscard]] friend constexpr bool operator<(const Decimal lhs, const Decimal rhs) noexcept { return lhs.units < rhs.units; }
+		[[nodiscard]] friend constexpr bool operator>(const Decimal lhs, const Decimal rhs) noexcept { return lhs.units > rhs.units; }
+		[[nodiscard]] friend constexpr bool operator<=(const Decimal lhs, const Decimal rhs) noexcept { return lhs.units <= rhs.units; }
+		[[nodiscard]] friend constexpr bool operator>=(const Decimal lhs, const Decimal rhs) noexcept { return lhs.units >= rhs.units; }
+	};
+
+	template <typename T> struct IsDecimal : std::false_type {};
+	template <unsigned Precision, unsigned Scale> struct IsDecimal<Decimal<Precision, Scale>> : std::true_type {};
+
+	// Column type for low-cardinality strings. Each distinct value is stored once and rows hold compact integer codes.
+	struct Dictionary {
+		std::string_view value;
+	};
+
+	// Interns each distinct value in an open-addressing hash table and stores one code per row. Codes start as 8 bits and
+	// are widened to 16 and then 32 bits as the number of distinct values grows.
+	class DictionaryColumn {
+
+		static constexpr std::uint32_t kEmptySlot = std::numeric_limits<std::uint32_t>::max();
+
+	public:
+		using Code = std::uint32_t;
+
+		void push_back(const Dictionary value) { Append(Intern(value.value)); }
+
+		void reserve(const std::size_t size) {
+			std::visit([size](auto& codes) { codes.reserve(size); }, codes_);
+		}
+
+		// Drops the codes from size onwards. Interned values are kept, so their codes stay valid.
+		void Truncate(const std::size_t size) {
+			std::visit([size](auto& codes) { codes.resize(size); }, codes_);
+		}
+
+		[[nodiscard]] std::string_view operator[](const std::size_t index) const { return Value(CodeAt(index)); }
+
+		[[nodiscard]] std::size_t size() const noexcept {
+			return std::visit([](const auto& codes) { return codes.size(); }, codes_);
+		}
+
+		[[nodiscard]] Code CodeAt(const std::size_t index) const {
+			return std::visit([index](const auto& codes) { return static_cast<Code>(codes[index]); }, codes_);
+		}
+
+		// The width of each code in bytes.
+		[[nodiscard]] std::size_t CodeWidth() const noexcept { return std::size_t{1} << codes_.index(); }
+
+		// Invokes visitor with a contiguous span of codes of the current width.
+		template <typename Visitor> decltype(auto) VisitCodes(Visitor&& visitor) const {
+			return std::visit([&](const auto& codes) {
+				using CodeType = typename std::decay_t<decltype(codes)>::value_type;
+				return visitor(Span<const CodeType>{codes.data(), codes.size()});
+			}, codes_);
+		}
+
+		[[nodiscard]] std::size_t DistinctCount() const noexcept { return hashes_.size(); }
+
+		[[nodiscard]] std::size_t MemoryUsage() const noexcept {
+			const auto codes = std::visit([](const auto& codes) { return codes.capacity() * sizeof(codes.front()); }, codes_);
+			return codes + bytes_.capacity() + offsets_.capacity() * sizeof(std::int32_t) + hashes_.capacity() * sizeof(std::size_t)
+				+ slots_.capacity() * sizeof(Code);
+		}
+
+		[[nodiscard]] std::string_view Value(const Code code) const noexcept {
+			return {bytes_.data() + offsets_[code], static_cast<std::size_t>(offsets_[code + 1] - offsets_[code])};
+		}
+
+		[[nodiscard]] std::optional<Code> Find(const std::string_view value) const noexcept {
+			if (slots_.empty()) {
+				return std::nullopt;
+			}
+			const auto hash = std::hash<std::string_view>{}(value);
+			for (auto slot = hash & (slots_.size() - 1);; slot = (slot + 1) & (slots_.size() - 1)) {
+				if (const auto code = slots_[slot]; code == kEmptySlot) {
+					return std::nullopt;
+				}
+				else if (hashes_[code] == hash && Value(code) == value) {
+					return code;
+				}
+			}
+		}
+
+		// Distinct values laid out as a string array: value i spans [ValueOffsets()[i], ValueOffsets()[i + 1]) of ValueBytes().
+		[[nodiscard]] Span<const std::int32_t> ValueOffsets() const noexcept { return {offsets_.data(), offsets_.size()}; }
+		[[nodiscard]] Span<const char> ValueBytes() const noexcept { return {bytes_.data(), bytes_.size()}; }
+
+	private:
+		Code Intern(const std::string_view value) {
+			if ((DistinctCount() + 1) * 2 > slots_.size()) {
+				Rehash(std::max<std::size_t>(slots_.size() * 2, 16));
+			}
+
+			const auto hash = std::hash<std::string_view>{}(value);
+			auto slot = hash & (slots_.size() - 1);
+			for (; slots_[slot] != kEmptySlot; slot = (slot + 1) & (slots_.size() - 1)) {
+				if (const auto code = slots_[slot]; hashes_[code] == hash && Value(code) == value) {
+					return code;
+				}
+			}
+
+			if (bytes_.size() + value.size() > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max())) {
+				throw std::runtime_error{"Dictionary values exceed the maximum size"};
+			}
+			const auto code = static_cast<Code>(DistinctCount());
+			bytes_.insert(bytes_.end(), value.begin(), value.end());
+			offsets_.push_back(static_cast<std::int32_t>(bytes_.size()));
+			hashes_.push_back(hash);
+			slots_[slot] = code;
+			return code;
+		}
+
+		void Rehash(const std::size_t slot_count) {
+			slots_.assign(slot_count, kEmptySlot);
+			for (Code code = 0; code < DistinctCount(); ++code) {
+				auto slot = hashes_[code] & (slot_count - 1);
+				while (slots_[slot] != kEmptySlot) {
+					slot = (slot + 1) & (slot_count - 1);
+				}
+				slots_[slot] = code;
+			}
+		}
+
+		void Append(const Code code) {
+			if (codes_.index() == 0 && code > std::numeric_limits<std::uint8_t>::max()) {
+				Widen<std::uint16_t>();
+			}
+			if (codes_.index() == 1 && code > std::numeric_limits<std::uint16_t>::max()) {
+				Widen<std::uint32_t>();
+			}
+			std::visit([code](auto& codes) {
+				using CodeType = typename std::decay_t<decltype(codes)>::value_type;
+				codes.push_back(static_cast<CodeType>(code));
+			}, codes_);
+		}
+
+		template <typename CodeType> void Widen() {
+			codes_ = std::visit([](const auto& codes) { return std::vector<CodeType>(codes.begin(), codes.end()); }, codes_);
+		}
+
+		std::variant<std::vector<std::uint8_t>, std::vector<std::uint16_t>, std::vector<std::uint32_t>> codes_;
+		std::vector<char> bytes_;
+		std::vector<std::int32_t> offsets_{0};
+		std::vector<std::size_t> hashes_;
+		std::vector<Code> slots_;
+	};
+
+	template <> struct ColumnTraits<Dictionary> {
+		using Storage = DictionaryColumn;
+		using View = const DictionaryColumn&;
+		using Reference = std::string_view;
+
+		static View MakeView(const Storage& storage) { return storage; }
+	};
+
+	// Approximate heap bytes held by a column, used to budget caches of parsed tables and to observe storage growth.
+	template <typename T> [[nodiscard]] std::size_t ColumnMemoryUsage(const std::vector<T>& column) noexcept { return column.capacity() * sizeof(T); }
+
+	template <typename Column> [[nodiscard]] auto ColumnMemoryUsage(const Column& column) noexcept -> decltype(column.MemoryUsage()) {
+		return column.MemoryUsage();
+	}
+
+	// Drops the values of a column from size onwards, used to undo a partially parsed record.
+	template <typename T> void TruncateColumn(std::vector<T>& column, const std::size_t size) {
+		column.erase(column.begin() + static_cast<std::ptrdiff_t>(size), column.end());
+	}
+
+	template <typename Column> auto TruncateColumn(Column& column, const std::size_t size) -> decltype(column.Truncate(size)) {
+		column.Truncate(size);
+	}
+
+	// Stores values contiguously alongside a validity bitmap. The bitmap is only materialized once the first null is
+	// appended, so columns without nulls can be scanned through Values() alone.
+	template <typename T> class NullableColumn {
+
+	public:
+		using ElementType = T;
+		using ValueType = std::remove_cv_t<std::remove_reference_t<typename ColumnTraits<T>::Reference>>;
+
+		void push_back(const std::optional<T>& value) {
+			if (value) {
+				values_.push_back(*value);
+				if (null_count_ != 0) {
+					validity_.push_back(true);
+				}
+			}
+			else {
+				if (null_count_ == 0) {
+					validity_ = BitVector{values_.size(), true};
+				}
+				values_.push_back(T{});
+				validity_.push_back(false);
+				++null_count_;
+			}
+		}
+
+		void reserve(const std::size_t size) { values_.reserve(size); }
+
+		void Truncate(const std::size_t size) {
+			TruncateColumn(values_, size);
+			if (null_count_ != 0) {
+				for (auto i = size; i < validity_.size(); ++i) {
+					null_count_ -= validity_[i] ? 0 : 1;
+				}
+				validity_.Truncate(size);
+			}
+			if (null_count_ == 0) {
+				validity_ = {};
+			}
+		}
+
+		[[nodiscard]] std::optional<ValueType> operator[](const std::size_t index) const {
+			if (IsValid(index)) {
+				return values_[index];
+			}
+			return std::nullopt;
+		}
+
+		[[nodiscard]] bool IsValid(const std::size_t index) const noexcept { return null_count_ == 0 || validity_[index]; }
+		[[nodiscard]] std::size_t size() const noexcept { return values_.size(); }
+		[[nodiscard]] std::size_t NullCount() const noexcept { return null_count_; }
+		[[nodiscard]] std::size_t MemoryUsage() const noexcept { return ColumnMemoryUsage(values_) + validity_.MemoryUsage(); }
+
+		// Null entries hold a value-initialized T.
+		[[nodiscard]] typename ColumnTraits<T>::View Values() const { return ColumnTraits<T>::MakeView(values_); }
+
+		// Empty when the column contains no nulls.
+		[[nodiscard]] const BitVector& Validity() const noexcept { return validity_; }
+
+	private:
+		typename ColumnTraits<T>::Storage values_;
+		BitVector validity_;
+		std::size_t null_count_ = 0;
+	};
+
+	template <typename T> struct ColumnTraits<std::optional<T>> {
+		using Storage = NullableColumn<T>;
+		using View = const NullableColumn<T>&;
+		using Reference = std::optional<typename NullableColumn<T>::ValueType>;
+
+		static View MakeView(const Storage& storage) { return storage; }
+	};
+
+	// Maps a key onto an unsigned integer with the same ordering, or returns void for keys without one.
+	template <typename T> auto RadixKey(const T key) noexcept {
+		if constexpr (std::is_same<T, bool>::value) {
+			return static_cast<std::uint8_t>(key);
+		}
+		else if constexpr (std::is_same<T, Date>::value) {
+			return RadixKey(key.days_since_epoch);
+		}
+		else if constexpr (IsDecimal<T>::value) {
+			if constexpr (sizeof(key.units) <= sizeof(std::int64_t)) {
+				return RadixKey(key.units);
+			}
+		}
+		else if constexpr (std::is_integral<T>::value) {
+			using Unsigned = std::make_unsigned_t<T>;
+			constexpr auto kSignBit = std::is_signed<T>::value ? Unsigned{1} << (std::numeric_limits<Unsigned>::digits - 1) : Unsigned{0};
+			return static_cast<Unsigned>(static_cast<Unsigned>(key) ^ kSignBit);
+		}
+	}
+
+	// Stable LSD radix sort of rows by key_of(row), one byte per pass. Passes in which every key shares the same byte are
+	// skipped, so narrow value ranges cost only the passes they need.
+	template <typename KeyOf> void RadixSortRows(std::vector<std::size_t>& rows, const KeyOf& key_of) {
+		using Bits = decltype(RadixKey(key_of(std::size_t{})));
+		std::vector<std::pair<Bits, std::size_t>> items(rows.size());
+		std::vector<std::pair<Bits, std::size_t>> scratch(rows.size());
+		std::transform(rows.begin(), rows.end(), items.begin(), [&](const std::size_t row) { return std::pair{RadixKey(key_of(row)), row}; });
+
+		for (unsigned shift = 0; shift < std::numeric_limits<Bits>::digits; shift += 8) {
+			std::size_t counts[256] = {};
+			for (const auto& item : items) {
+				++counts[(item.first >> shift) & 0xFF];
+			}
+			if (std::find(std::begin(counts), std::end(counts), items.size()) != std::end(counts)) {
+				continue;
+			}
+
+			std::size_t offset = 0;
+			for (auto& count : counts) {
+				offset += std::exchange(count, offset);
+			}
+			for (const auto& item : items) {
+				scratch[counts[(item.first >> shift) & 0xFF]++] = item;
+			}
+			items.swap(scratch);
+		}
+
+		std::transform(items.begin(), items.end(), rows.begin(), [](const auto& item) { return item.second; });
+	}
+
+	// Work over rows is split across one thread per core, each given at least 16K rows.
+	inline std::size_t ThreadCount(const std::size_t row_count) noexcept {
+		constexpr std::size_t kMinRowsPerThread = 1 << 14;
+		return std::clamp<std::size_t>(row_count / kMinRowsPerThread, 1, std::max(std::thread::hardware_concurrency(), 1u));
+	}
+
+	// Runs task(index) for each index in [0, count) on its own thread, the first on the calling thread. Exceptions thrown by
+	// a task are rethrown once every task has finished.
+	template <typename Task> void RunParallel(const std::size_t count, const Task& task) {
+		std::vector<std::exception_ptr> errors(count);
+		const auto run = [&](const std::size_t index) {
+			try {
+				task(index);
+			}
+			catch (...) {
+				errors[index] = std::current_exception();
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (std::size_t index = 1; index < count; ++index) {
+			threads.emplace_back(run, index);
+		}
+		if (count != 0) {
+			run(0);
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+
+		for (const auto& error : errors) {
+			if (error) {
+				std::rethrow_exception(error);
+			}
+		}
+	}
+
+	// Stable merge sort of rows on up to one thread per core: each thread sorts a slice, then neighbouring slices are
+	// merged in parallel rounds.
+	template <typename Less> void ParallelSortRows(std::vector<std::size_t>& rows, const Less& less) {
+		const auto thread_count = ThreadCount(rows.size());
+
+		std::vector<std::vector<std::size_t>::iterator> bounds;
+		for (std::size_t slice = 0; slice <= thread_count; ++slice) {
+			bounds.push_back(rows.begin() + static_cast<std::ptrdiff_t>(rows.size() * slice / thread_count));
+		}
+
+		RunParallel(thread_count, [&](const std::size_t slice) { std::stable_sort(bounds[slice], bounds[slice + 1], less); });
+
+		for (std::size_t width = 1; width < thread_count; width *= 2) {
+			const auto merge_count = (thread_count - width + 2 * width - 1) / (2 * width);
+			RunParallel(merge_count, [&](const std::size_t merge) {
+				const auto slice = merge * 2 * width;
+				std::inplace_merge(bounds[slice], bounds[slice + width], bounds[std::min(slice + 2 * width, thread_count)], less);
+			});
+		}
+	}
+
+	// Stable sort of rows by key_of(row): radix sorted for integer, boolean and date keys and merge sorted otherwise.
+	template <typename KeyOf> void StableSortRows(std::vector<std::size_t>& rows, const KeyOf& key_of) {
+		using Key = std::decay_t<decltype(key_of(std::size_t{}))>;
+		if constexpr (!std::is_void<decltype(RadixKey(std::declval<Key>()))>::value) {
+			RadixSortRows(rows, key_of);
+		}
+		else {
+			ParallelSortRows(rows, [&](const std::size_t lhs, const std::size_t rhs) { return key_of(lhs) < key_of(rhs); });
+		}
+	}
+
+	// Stable sort of rows by the values of a column. Null values order before all others.
+	template <typename Storage> void SortRowsByColumn(std::vector<std::size_t>& rows, const Storage& column) {
+		StableSortRows(rows, [&](const std::size_t row) -> decltype(auto) { return column[row]; });
+	}
+
+	template <typename T> void SortRowsByColumn(std::vector<std::size_t>& rows, const NullableColumn<T>& column) {
+		const auto& values = column.Values();
+		if (column.NullCount() == 0) {
+			StableSortRows(rows, [&](const std::size_t row) -> decltype(auto) { return values[row]; });
+		}
+		else {
+			ParallelSortRows(rows, [&](const std::size_t lhs, const std::size_t rhs) {
+				const auto lhs_valid = column.IsValid(lhs), rhs_valid = column.IsValid(rhs);
+				return lhs_valid != rhs_valid ? rhs_valid : lhs_valid && values[lhs] < values[rhs];
+			});
+		}
+	}
+
+	// Gathers the values of a column in the given row order.
+	template <typename Storage> Storage PermuteColumn(const Storage& column, const std::vector<std::size_t>& order) {
+		Storage permuted;
+		permuted.reserve(order.size());
+		for (const auto row : order) {
+			if constexpr (std::is_same<Storage, DictionaryColumn>::value) {
+				permuted.push_back(Dictionary{column[row]});
+			}
+			else {
+				permuted.push_back(column[row]);
+			}
+		}
+		return permuted;
+	}
+
+	template <typename T> NullableColumn<T> PermuteColumn(const NullableColumn<T>& column, const std::vector<std::size_t>& order) {
+		NullableColumn<T> permuted;
+		permuted.reserve(order.size());
+		for (const auto row : order) {
+			const auto value = column[row];
+			permuted.push_back(value ? std::optional<T>{T{*value}} : std::nullopt);
+		}
+		return permuted;
+	}
+
+	template <typename Table> class RowIterator {
+
+		struct ArrowProxy {
+			typename Table::RowType row;
+			const typename Table::RowType* operator->() const noexcept { return &row; }
+		};
+
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = typename Table::RowType;
+		using difference_type = std::ptrdiff_t;
+		using pointer = ArrowProxy;
+		using reference = value_type;
+
+		RowIterator() noexcept = default;
+		RowIterator(const Table* const table, const std::size_t index) noexcept : table_{table}, index_{index} {}
+
+		[[nodiscard]] reference operator*() const { return table_->RowAt(index_); }
+		[[nodiscard]] pointer operator->() const { return {table_->RowAt(index_)}; }
+		[[nodiscard]] reference operator[](const difference_type offset) const { return table_->RowAt(index_ + offset); }
+
+		RowIterator& operator++() noexcept { ++index_; return *this; }
+		RowIterator& operator--() noexcept { --index_; return *this; }
+		RowIterator operator++(int) noexcept { auto copy = *this; ++index_; return copy; }
+		RowIterator operator--(int) noexcept { auto copy = *this; --index_; return copy; }
+		RowIterator& operator+=(const difference_type offset) noexcept { index_ += offset; return *this; }
+		RowIterator& operator-=(const difference_type offset) noexcept { index_ -= offset; return *this; }
+
+		[[nodiscard]] friend RowIterator operator+(RowIterator it, const difference_type offset) noexcept { return it += offset; }
+		[[nodiscard]] friend RowIterator operator+(const difference_type offset, RowIterator it) noexcept { return it += offset; }
+		[[nodiscard]] friend RowIterator operator-(RowIterator it, const difference_type offset) noexcept { return it -= offset; }
+		[[nodiscard]] friend difference_type operator-(const RowIterator& lhs, const RowIterator& rhs) noexcept {
+			return static_cast<difference_type>(lhs.index_) - static_cast<difference_type>(rhs.index_);
+		}
+
+		[[nodiscard]] friend bool operator==(const RowIterator& lhs, const RowIterator& rhs) noexcept { return lhs.index_ == rhs.index_; }
+		[[nodiscard]] friend bool operator!=(const RowIterator& lhs, const RowIterator& rhs) noexcept { return lhs.index_ != rhs.index_; }
+		[[nodiscard]] friend bool operator<(const RowIterator& lhs, const RowIterator& rhs) noexcept { return lhs.index_ < rhs.index_; }
+		[[nodiscard]] friend bool operator>(const RowIterator& lhs, const RowIterator& rhs) noexcept { return lhs.index_ > rhs.index_; }
+		[[nodiscard]] friend bool operator<=(const RowIterator& lhs, const RowIterator& rhs) noexcept { return lhs.index_ <= rhs.index_; }
+		[[nodiscard]] friend bool operator>=(const RowIterator& lhs, const RowIterator& rhs) noexcept { return lhs.index_ >= rhs.index_; }
+
+	private:
+		const Table* table_ = nullptr;
+		std::size_t index_ = 0;
+	};
+
+	template <typename Iterator> class RowRange {
+
+	public:
+		RowRange(const Iterator first, const Iterator last) noexcept : first_{first}, last_{last} {}
+
+		[[nodiscard]] Iterator begin() const noexcept { return first_; }
+		[[nodiscard]] Iterator end() const noexcept { return last_; }
+		[[nodiscard]] std::size_t size() const noexcept { return static_cast<std::size_t>(last_ - first_); }
+		[[nodiscard]] bool empty() const noexcept { return first_ == last_; }
+
+	private:
+		Iterator first_;
+		Iterator last_;
+	};
+
+	class InputSource {
+
+	public:
+		virtual ~InputSource() = default;
+
+		// Reads up to size bytes into buffer and returns the number of bytes read, or zero once the input is exhausted.
+		virtual std::size_t Read(char* buffer, std::size_t size) = 0;
+	};
+
+	class BufferSource final : public InputSource {
+
+	public:
+		explicit BufferSource(const std::string_view data) noexcept : data_{data} {}
+
+		std::size_t Read(char* const buffer, const std::size_t size) override {
+			const auto count = std::min(size, data_.size() - offset_);
+			std::memcpy(buffer, data_.data() + offset_, count);
+			offset_ += count;
+			return count;
+		}
+
+	private:
+		std::string_view data_;
+		std::size_t offset_ = 0;
+	};
+
+	class StreamSource final : public InputSource {
+
+	public:
+		explicit StreamSource(std::istream& stream) noexcept : stream_{stream} {}
+
+		std::size_t Read(char* const buffer, const std::size_t size) override {
+			stream_.read(buffer, static_cast<std::streamsize>(size));
+			if (stream_.bad()) {
+				throw std::runtime_error{"Failed to read from stream"};
+			}
+			return static_cast<std::size_t>(stream_.gcount());
+		}
+
+	private:
+		std::istream& stream_;
+	};
+
+	class FileSource final : public InputSource {
+
+	public:
+		explicit FileSource(const std::string& path) : file_{path, std::ios::binary} {
+			if (!file_) {
+				throw std::runtime_error{"Unable to open " + path};
+			}
+		}
+
+		std::size_t Read(char* const buffer, const std::size_t size) override {
+			file_.read(buffer, static_cast<std::streamsize>(size));
+			if (file_.bad()) {
+				throw std::runtime_error{"Failed to read from file"};
+			}
+			return static_cast<std::size_t>(file_.gcount());
+		}
+
+	private:
+		std::ifstream file_;
+	};
+
+	// Reads the next block from the underlying source on a dedicated thread while the current block is being parsed.
+	class ReadAheadSource final : public InputSource {
+
+		// A failed read leaves an empty block holding its error, so blocks read before it are still consumed first.
+		struct Block {
+			std::vector<char> data;
+			std::size_t size = 0;
+			std::exception_ptr error;
+			bool ready = false;
+		};
+
+	public:
+		static constexpr std::size_t kDefaultBlockSize = 1 << 20;
+
+		explicit ReadAheadSource(InputSource& source, const std::size_t block_size = kDefaultBlockSize)
+			: source_{source} {
+			for (auto& block : blocks_) {
+				block.data.resize(std::max<std::size_t>(block_size, 1));
+			}
+			reader_ = std::thread{[this] { ReadBlocks(); }};
+		}
+
+		ReadAheadSource(const ReadAheadSource&) = delete;
+		ReadAheadSource& operator=(const ReadAheadSource&) = delete;
+
+		~ReadAheadSource() override {
+			{
+				std::lock_guard lock{mutex_};
+				stopped_ = true;
+			}
+			block_consumed_.notify_one();
+			reader_.join();
+		}
+
+		std::size_t Read(char* const buffer, const std::size_t size) override {
+			auto& block = blocks_[current_];
+			{
+				std::unique_lock lock{mutex_};
+				block_ready_.wait(lock, [&] { return block.ready; });
+				if (block.error) {
+					std::rethrow_exception(block.error);
+				}
+			}
+
+			const auto count = std::min(size, block.size - offset_);
+			std::memcpy(buffer, block.data.data() + offset_, count);
+			offset_ += count;
+
+			if (offset_ == block.size && block.size != 0) {
+				{
+					std::lock_guard lock{mutex_};
+					block.ready = false;
+				}
+				block_consumed_.notify_one();
+				current_ ^= 1;
+				offset_ = 0;
+			}
+
+			return count;
+		}
+
+	private:
+		void ReadBlocks() {
+			for (std::size_t next = 0;; next ^= 1) {
+				auto& block = blocks_[next];
+				{
+					std::unique_lock lock{mutex_};
+					block_consumed_.wait(lock, [&] { return stopped_ || !block.ready; });
+					if (stopped_) {
+						return;
+					}
+				}
+
+				std::size_t size = 0;
+				std::exception_ptr error;
+				try {
+					size = source_.Read(block.data.data(), block.data.size());
+				}
+				catch (...) {
+					error = std::current_exception();
+				}
+
+				{
+					std::lock_guard lock{mutex_};
+					block.size = size;
+					block.error = error;
+					block.ready = true;
+				}
+				block_ready_.notify_one();
+
+				if (size == 0) {
+					return;
+				}
+			}
+		}
+
+		InputSource& source_;
+		Block blocks_[2];
+		std::size_t current_ = 0;
+		std::size_t offset_ = 0;
+		std::mutex mutex_;
+		std::condition_variable block_ready_;
+		std::condition_variable block_consumed_;
+		bool stopped_ = false;
+		std::thread reader_;
+	};
+
+#ifdef CSV_HAS_POSIX_IO
+
+	class FileDescriptor {
+
+	public:
+		FileDescriptor(const std::string& path, const int flags) : fd_{::open(path.c_str(), flags)} {
+			if (fd_ == -1) {
+				throw std::system_error{errno, std::generic_category(), "Unable to open " + path};
+			}
+		}
+
+		FileDescriptor(const FileDescriptor&) = delete;
+		FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+		~FileDescriptor() { ::close(fd_); }
+
+		[[nodiscard]] int Get() const noexcept { return fd_; }
+
+		[[nodiscard]] std::size_t Size() const {
+			struct stat status {};
+			if (::fstat(fd_, &status) == -1) {
+				throw std::runtime_error{std::string{"Unable to stat file: "} + std::strerror(errno)};
+			}
+			return static_cast<std::size_t>(status.st_size);
+		}
+
+	private:
+		int fd_;
+	};
+
+	class MappedFile {
+
+	public:
+		explicit MappedFile(const std::string& path) : file_{path, O_RDONLY}, size_{file_.Size()} {
+			if (size_ == 0) {
+				return;
+			}
+			data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file_.Get(), 0);
+			if (data_ == MAP_FAILED) {
+				throw std::runtime_error{"Unable to map " + path + ": " + std::strerror(errno)};
+			}
+			::madvise(data_, size_, MADV_SEQUENTIAL);
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		~MappedFile() {
+			if (size_ != 0) {
+				::munmap(data_, size_);
+			}
+		}
+
+		[[nodiscard]] std::string_view Data() const noexcept { return {static_cast<const char*>(data_), size_}; }
+
+	private:
+		FileDescriptor file_;
+		std::size_t size_;
+		void* data_ = nullptr;
+	};
+
+	class PreadSource final : public InputSource {
+
+	public:
+		explicit PreadSource(const std::string& path) : file_{path, O_RDONLY} {
+#ifdef POSIX_FADV_SEQUENTIAL
+			::posix_fadvise(file_.Get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+		}
+
+		std::size_t Read(char* const buffer, const std::size_t size) override {
+			for (;;) {
+				if (const auto count = ::pread(file_.Get(), buffer, size, static_cast<off_t>(offset_)); count >= 0) {
+					offset_ += static_cast<std::size_t>(count);
+					return static_cast<std::size_t>(count);
+				}
+				if (errno != EINTR) {
+					throw std::runtime_error{std::string{"Failed to read from file: "} + std::strerror(errno)};
+				}
+			}
+		}
+
+	private:
+		FileDescriptor file_;
+		std::size_t offset_ = 0;
+	};
+
+#endif
+
+#ifdef CSV_HAS_IO_URING
+
+	class IoUringUnavailable final : public std::runtime_error {
+
+	public:
+		using std::runtime_error::runtime_error;
+	};
+
+	// Keeps queue_depth block reads in flight against registered buffers and hands completed blocks out in file order.
+	class IoUringSource final : public InputSource {
+
+		static constexpr std::size_t kAlignment = 4096;
+
+		enum class SlotState { kIdle, kInFlight, kComplete };
+
+		struct Slot {
+			char* data = nullptr;
+			std::size_t offset = 0;
+			std::size_t length = 0;
+			std::size_t filled = 0;
+			std::size_t consumed = 0;
+			int result = 0;
+			SlotState state = SlotState::kIdle;
+		};
+
+	public:
+		explicit IoUringSource(
+			const std::string& path, const std::size_t block_size = 1 << 20, const unsigned queue_depth = 4, const bool direct = false)
+			: file_{Open(path, direct)},
+			  file_size_{file_.Size()},
+			  block_size_{(std::max<std::size_t>(block_size, 1) + kAlignment - 1) / kAlignment * kAlignment},
+			  slots_(std::max(queue_depth, 1u)) {
+
+			io_uring_params params{};
+			ring_fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, static_cast<unsigned>(slots_.size()), &params));
+			if (ring_fd_ == -1) {
+				throw IoUringUnavailable{std::string{"io_uring is unavailable: "} + std::strerror(errno)};
+			}
+
+			try {
+				MapRings(params);
+				AllocateBuffers();
+			}
+			catch (...) {
+				Release();
+				throw;
+			}
+
+			for (auto& slot : slots_) {
+				Schedule(slot);
+			}
+		}
+
+		IoUringSource(const IoUringSource&) = delete;
+		IoUringSource& operator=(const IoUringSource&) = delete;
+
+		~IoUringSource() override {
+			try {
+				while (std::any_of(slots_.begin(), slots_.end(), [](const auto& slot) { return slot.state == SlotState::kInFlight; })) {
+					Enter(1);
+					Reap();
+				}
+			}
+			catch (...) {
+			}
+			Release();
+		}
+
+		std::size_t Read(char* const buffer, const std::size_t size) override {
+			auto& slot = slots_[current_];
+			if (size == 0 || slot.state == SlotState::kIdle) {
+				return 0;
+			}
+
+			while (slot.state != SlotState::kComplete) {
+				Enter(1);
+				Reap();
+			}
+			if (slot.result < 0) {
+				throw std::runtime_error{std::string{"Failed to read from file: "} + std::strerror(-slot.result)};
+			}
+
+			const auto count = slot.filled > slot.consumed ? std::min(size, slot.filled - slot.consumed) : 0;
+			std::memcpy(buffer, slot.data + slot.consumed, count);
+			slot.consumed += count;
+
+			if (slot.consumed >= slot.filled) {
+				if (count != 0 && slot.filled < slot.length) {
+					// resume a short read from the aligned position before it, as O_DIRECT rejects unaligned offsets
+					SubmitRead(slot, slot.consumed / kAlignment * kAlignment);
+				}
+				else {
+					Schedule(slot);
+					current_ = (current_ + 1) % slots_.size();
+				}
+			}
+
+			return count == 0 ? Read(buffer, size) : count;
+		}
+
+		[[nodiscard]] bool UsesRegisteredBuffers() const noexcept { return registered_buffers_; }
+
+	private:
+		// Filesystems such as tmpfs refuse O_DIRECT with EINVAL, which OpenFile answers with buffered reads.
+		static FileDescriptor Open(const std::string& path, const bool direct) {
+			try {
+				return FileDescriptor{path, O_RDONLY | (direct ? O_DIRECT : 0)};
+			}
+			catch (const std::system_error& error) {
+				if (direct && error.code() == std::errc::invalid_argument) {
+					throw IoUringUnavailable{std::string{"Direct I/O is unavailable: "} + error.what()};
+				}
+				throw;
+			}
+		}
+
+		template <typename T> static T* RingPointer(void* const ring, const unsigned offset) noexcept {
+			return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+		}
+
+		void MapRings(const io_uring_params& params) {
+			sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+			cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			const auto single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+			if (single_mmap) {
+				sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+			}
+
+			sq_ring_ = Map(sq_ring_size_, IORING_OFF_SQ_RING);
+			cq_ring_ = single_mmap ? sq_ring_ : Map(cq_ring_size_, IORING_OFF_CQ_RING);
+			sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+			sqes_ = static_cast<io_uring_sqe*>(Map(sqes_size_, IORING_OFF_SQES));
+
+			sq_tail_ = RingPointer<unsigned>(sq_ring_, params.sq_off.tail);
+			sq_mask_ = *RingPointer<unsigned>(sq_ring_, params.sq_off.ring_mask);
+			sq_array_ = RingPointer<unsigned>(sq_ring_, params.sq_off.array);
+			cq_head_ = RingPointer<unsigned>(cq_ring_, params.cq_off.head);
+			cq_tail_ = RingPointer<unsigned>(cq_ring_, params.cq_off.tail);
+			cq_mask_ = *RingPointer<unsigned>(cq_ring_, params.cq_off.ring_mask);
+			cqes_ = RingPointer<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+		}
+
+		void* Map(const std::size_t size, const off_t offset) const {
+			auto* const ring = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+			if (ring == MAP_FAILED) {
+				throw IoUringUnavailable{std::string{"Unable to map io_uring: "} + std::strerror(errno)};
+			}
+			return ring;
+		}
+
+		void AllocateBuffers() {
+			buffers_ = static_cast<char*>(std::aligned_alloc(kAlignment, block_size_ * slots_.size()));
+			if (buffers_ == nullptr) {
+				throw std::bad_alloc{};
+			}
+
+			std::vector<iovec> iovecs(slots_.size());
+			for (std::size_t i = 0; i < slots_.size(); ++i) {
+				slots_[i].data = buffers_ + i * block_size_;
+				iovecs[i] = {slots_[i].data, block_size_};
+			}
+			registered_buffers_ = ::syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS, iovecs.data(), iovecs.size()) == 0;
+		}
+
+		void Release() noexcept {
+			if (sqes_ != nullptr) {
+				::munmap(sqes_, sqes_size_);
+			}
+			if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+				::munmap(cq_ring_, cq_ring_size_);
+			}
+			if (sq_ring_ != nullptr) {
+				::munmap(sq_ring_, sq_ring_size_);
+			}
+			if (ring_fd_ != -1) {
+				::close(ring_fd_);
+			}
+			std::free(buffers_);
+		}
+
+		void Schedule(Slot& slot) {
+			slot.state = SlotState::kIdle;
+			if (next_offset_ < file_size_) {
+				Submit(slot, next_offset_, std::min(block_size_, file_size_ - next_offset_));
+				next_offset_ += slot.length;
+			}
+		}
+
+		void Submit(Slot& slot, const std::size_t offset, const std::size_t length) {
+			slot.offset = offset;
+			slot.length = length;
+			slot.consumed = 0;
+			SubmitRead(slot, 0);
+		}
+
+		// Reads the rest of the slot's block from start, which must be aligned, keeping the bytes before it.
+		void SubmitRead(Slot& slot, const std::size_t start) {
+			const auto slot_index = static_cast<std::size_t>(&slot - slots_.data());
+			const auto tail = *sq_tail_;
+			const auto index = tail & sq_mask_;
+
+			auto& sqe = sqes_[index];
+			std::memset(&sqe, 0, sizeof sqe);
+			sqe.opcode = registered_buffers_ ? IORING_OP_READ_FIXED : IORING_OP_READ;
+			sqe.fd = file_.Get();
+			sqe.off = slot.offset + start;
+			sqe.addr = reinterpret_cast<std::uintptr_t>(slot.data + start);
+			sqe.len = static_cast<unsigned>(AlignedLength(slot.length - start));
+			if (registered_buffers_) {
+				sqe.buf_index = static_cast<std::uint16_t>(slot_index);
+			}
+			sqe.user_data = slot_index;
+			sq_array_[index] = index;
+			__atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+			slot.filled = start;
+			slot.state = SlotState::kInFlight;
+			++pending_submissions_;
+		}
+
+		// O_DIRECT reads must cover whole aligned blocks, the kernel stops at the end of the file regardless
+		[[nodiscard]] static std::size_t AlignedLength(const std::size_t length) noexcept {
+			return (length + kAlignment - 1) / kAlignment * kAlignment;
+		}
+
+		void Enter(const unsigned min_complete) {
+			for (;;) {
+				const auto submitted = ::syscall(
+					__NR_io_uring_enter, ring_fd_, pending_submissions_, min_complete, IORING_ENTER_GETEVENTS, nullptr, 0);
+				if (submitted >= 0) {
+					pending_submissions_ -= static_cast<unsigned>(submitted);
+					return;
+				}
+				if (errno != EINTR) {
+					throw std::runtime_error{std::string{"io_uring_enter failed: "} + std::strerror(errno)};
+				}
+			}
+		}
+
+		void Reap() noexcept {
+			auto head = *cq_head_;
+			for (const auto tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE); head != tail; ++head) {
+				const auto& cqe = cqes_[head & cq_mask_];
+				auto& slot = slots_[cqe.user_data];
+				slot.result = cqe.res;
+				slot.filled = cqe.res > 0 ? std::min(slot.filled + static_cast<std::size_t>(cqe.res), slot.length) : slot.filled;
+				slot.state = SlotState::kComplete;
+			}
+			__atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+		}
+
+		FileDescriptor file_;
+		std::size_t file_size_;
+		std::size_t block_size_;
+		std::vector<Slot> slots_;
+		std::size_t current_ = 0;
+		std::size_t next_offset_ = 0;
+		char* buffers_ = nullptr;
+		bool registered_buffers_ = false;
+		unsigned pending_submissions_ = 0;
+
+		int ring_fd_ = -1;
+		void* sq_ring_ = nullptr;
+		void* cq_ring_ = nullptr;
+		std::size_t sq_ring_size_ = 0;
+		std::size_t cq_ring_size_ = 0;
+		io_uring_sqe* sqes_ = nullptr;
+		std::size_t sqes_size_ = 0;
+		unsigned* sq_tail_ = nullptr;
+		unsigned* sq_array_ = nullptr;
+		unsigned sq_mask_ = 0;
+		unsigned* cq_head_ = nullptr;
+		unsigned* cq_tail_ = nullptr;
+		unsigned cq_mask_ = 0;
+		io_uring_cqe* cqes_ = nullptr;
+	};
+
+#endif
+
+	struct FileReadOptions {
+		std::size_t block_size = 1 << 20;
+		unsigned queue_depth = 4;
+		bool direct = false;
+	};
+
+	// Opens the fastest available file source: io_uring on Linux, then pread, then buffered stream reads.
+	inline std::unique_ptr<InputSource> OpenFile(const std::string& path, const FileReadOptions& options = {}) {
+#if defined(CSV_HAS_IO_URING)
+		try {
+			return std::make_unique<IoUringSource>(path, options.block_size, options.queue_depth, options.direct);
+		}
+		catch (const IoUringUnavailable&) {
+			// io_uring, or direct I/O on this filesystem, is unsupported
+			return std::make_unique<PreadSource>(path);
+		}
+#elif defined(CSV_HAS_POSIX_IO)
+		return std::make_unique<PreadSource>(path);
+#else
+		return std::make_unique<FileSource>(path);
+#endif
+	}
+
+	template <typename T> class BoundedQueue {
+
+	public:
+		explicit BoundedQueue(const std::size_t capacity) noexcept : capacity_{std::max<std::size_t>(capacity, 1)} {}
+
+		// Blocks while the queue is full. Returns false if the queue was closed before the item could be added.
+		bool Push(T item) {
+			std::unique_lock lock{mutex_};
+			not_full_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+			if (closed_) {
+				return false;
+			}
+			items_.push_back(std::move(item));
+			lock.unlock();
+			not_empty_.notify_one();
+			return true;
+		}
+
+		// Blocks while the queue is empty. Returns false once the queue is closed and drained.
+		bool Pop(T& item) {
+			std::unique_lock lock{mutex_};
+			not_empty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+			if (items_.empty()) {
+				return false;
+			}
+			item = std::move(items_.front());
+			items_.pop_front();
+			lock.unlock();
+			not_full_.notify_one();
+			return true;
+		}
+
+		void Close() {
+			{
+				std::lock_guard lock{mutex_};
+				closed_ = true;
+			}
+			not_full_.notify_all();
+			not_empty_.notify_all();
+		}
+
+	private:
+		std::size_t capacity_;
+		std::deque<T> items_;
+		std::mutex mutex_;
+		std::condition_variable not_full_;
+		std::condition_variable not_empty_;
+		bool closed_ = false;
+	};
+
+	struct DecompressResult {
+		std::size_t consumed;
+		std::size_t produced;
+	};
+
+	// Decompresses blocks of the underlying source on a dedicated thread and hands the decompressed chunks to the parser.
+	template <typename Codec> class DecompressingSource final : public InputSource {
+
+	public:
+		static constexpr std::size_t kDefaultChunkSize = 1 << 20;
+		static constexpr std::size_t kDefaultQueueCapacity = 4;
+
+		explicit DecompressingSource(
+			InputSource& source, const std::size_t chunk_size = kDefaultChunkSize, const std::size_t queue_capacity = kDefaultQueueCapacity)
+			: source_{source}, chunk_size_{std::max<std::size_t>(chunk_size, 1)}, chunks_{queue_capacity} {
+			decompressor_ = std::thread{[this] { DecompressChunks(); }};
+		}
+
+		DecompressingSource(const DecompressingSource&) = delete;
+		DecompressingSource& operator=(const DecompressingSource&) = delete;
+
+		~DecompressingSource() override {
+			chunks_.Close();
+			decompressor_.join();
+		}
+
+		std::size_t Read(char* const buffer, const std::size_t size) override {
+			while (offset_ == chunk_.size()) {
+				if (!chunks_.Pop(chunk_)) {
+					chunk_.clear();
+					offset_ = 0;
+					if (error_) {
+						std::rethrow_exception(error_);
+					}
+					return 0;
+				}
+				offset_ = 0;
+			}
+
+			const auto count = std::min(size, chunk_.size() - offset_);
+			std::memcpy(buffer, chunk_.data() + offset_, count);
+			offset_ += count;
+			return count;
+		}
+
+	private:
+		void DecompressChunks() {
+			try {
+				Codec codec;
+				std::vector<char> input(chunk_size_);
+				std::size_t input_begin = 0, input_end = 0;
+				auto input_exhausted = false;
+
+				for (;;) {
+					if (input_begin == input_end && !input_exhausted) {
+						input_begin = 0;
+						input_end = source_.Read(input.data(), input.size());
+						input_exhausted = input_end == 0;
+					}
+
+					std::vector<char> output(chunk_size_);
+					const auto [consumed, produced] = codec.Decompress(
+						input.data() + input_begin, input_end - input_begin, output.data(), output.size());
+					input_begin += consumed;
+
+					if (produced != 0) {
+						output.resize(produced);
+						if (!chunks_.Push(std::move(output))) {
+							return;
+						}
+					}
+					else if (input_begin == input_end && input_exhausted) {
+						if (!codec.Finished()) {
+							throw std::runtime_error{"Compressed input is truncated"};
+						}
+						break;
+					}
+					else if (consumed == 0) {
+						throw std::runtime_error{"Compressed input is corrupt"};
+					}
+				}
+			}
+			catch (...) {
+				error_ = std::current_exception();
+			}
+			chunks_.Close();
+		}
+
+		InputSource& source_;
+		std::size_t chunk_size_;
+		BoundedQueue<std::vector<char>> chunks_;
+		std::vector<char> chunk_;
+		std::size_t offset_ = 0;
+		std::exception_ptr error_;
+		std::thread decompressor_;
+	};
+
+#ifdef CSV_HAS_ZLIB
+
+	// Inflates gzip or zlib streams, including multiple concatenated gzip members.
+	class GzipCodec {
+
+	public:
+		GzipCodec() {
+			if (inflateInit2(&stream_, 15 + 32) != Z_OK) {
+				throw std::runtime_error{"Unable to initialize zlib"};
+			}
+		}
+
+		GzipCodec(const GzipCodec&) = delete;
+		GzipCodec& operator=(const GzipCodec&) = delete;
+
+		~GzipCodec() { inflateEnd(&stream_); }
+
+		DecompressResult Decompress(const char* const input, const std::size_t input_size, char* const output, const std::size_t output_size) {
+			if (finished_ && input_size != 0) {
+				inflateReset(&stream_);
+				finished_ = false;
+			}
+
+			stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input));
+			stream_.avail_in = static_cast<uInt>(std::min<std::size_t>(input_size, std::numeric_limits<uInt>::max()));
+			stream_.next_out = reinterpret_cast<Bytef*>(output);
+			stream_.avail_out = static_cast<uInt>(std::min<std::size_t>(output_size, std::numeric_limits<uInt>::max()));
+			const auto available_in = stream_.avail_in;
+			const auto available_out = stream_.avail_out;
+
+			switch (inflate(&stream_, Z_NO_FLUSH)) {
+				case Z_OK:
+				case Z_BUF_ERROR:
+					break;
+				case Z_STREAM_END:
+					finished_ = true;
+					break;
+				default:
+					throw std::runtime_error{std::string{"Failed to inflate input: "} + (stream_.msg ? stream_.msg : "unknown error")};
+			}
+
+			return {available_in - stream_.avail_in, available_out - stream_.avail_out};
+		}
+
+		[[nodiscard]] bool Finished() const noexcept { return finished_; }
+
+	private:
+		z_stream stream_{};
+		bool finished_ = false;
+	};
+
+	using GzipSource = DecompressingSource<GzipCodec>;
+
+#endif
+
+#ifdef CSV_HAS_ZSTD
+
+	class ZstdCodec {
+
+	public:
+		ZstdCodec() : context_{ZSTD_createDCtx()} {
+			if (context_ == nullptr) {
+				throw std::runtime_error{"Unable to initialize zstd"};
+			}
+		}
+
+		ZstdCodec(const ZstdCodec&) = delete;
+		ZstdCodec& operator=(const ZstdCodec&) = delete;
+
+		~ZstdCodec() { ZSTD_freeDCtx(context_); }
+
+		DecompressResult Decompress(const char* const input, const std::size_t input_size, char* const output, const std::size_t output_size) {
+			ZSTD_inBuffer in{input, input_size, 0};
+			ZSTD_outBuffer out{output, output_size, 0};
+
+			if (const auto result = ZSTD_decompressStream(context_, &out, &in); ZSTD_isError(result)) {
+				throw std::runtime_error{std::string{"Failed to decompress input: "} + ZSTD_getErrorName(result)};
+			}
+			else if (in.pos != 0 || out.pos != 0) {
+				finished_ = result == 0;
+			}
+
+			return {in.pos, out.pos};
+		}
+
+		[[nodiscard]] bool Finished() const noexcept { return finished_; }
+
+	private:
+		ZSTD_DCtx* context_;
+		bool finished_ = false;
+	};
+
+	using ZstdSource = DecompressingSource<ZstdCodec>;
+
+#endif
+
+	constexpr std::string_view kUtf8Bom{"\xEF\xBB\xBF"};
+
+	[[nodiscard]] constexpr bool HasUtf8Bom(const std::string_view data) noexcept { return data.substr(0, kUtf8Bom.size()) == kUtf8Bom; }
+
+	// Returns the offset of the first byte of the first ill-formed UTF-8 sequence in data, or npos if it is well formed.
+	// Overlong encodings, surrogates and code points above U+10FFFF are ill formed. ASCII is skipped eight bytes at a time.
+	[[nodiscard]] inline std::size_t FindInvalidUtf8(const std::string_view data) noexcept {
+		constexpr std::uint64_t kHighBits = 0x8080808080808080;
+		const auto* const bytes = reinterpret_cast<const unsigned char*>(data.data());
+
+		for (std::size_t i = 0; i < data.size();) {
+			if (std::uint64_t word; data.size() - i >= sizeof(word)) {
+				std::memcpy(&word, bytes + i, sizeof(word));
+				if ((word & kHighBits) == 0) {
+					i += sizeof(word);
+					continue;
+				}
+			}
+
+			const auto lead = bytes[i];
+			if (lead < 0x80) {
+				++i;
+				continue;
+			}
+
+			// The valid range of the second byte excludes overlong forms, surrogates and values past U+10FFFF.
+			std::size_t length = 0;
+			unsigned char second_min = 0x80, second_max = 0xBF;
+			if (lead >= 0xC2 && lead <= 0xDF) {
+				length = 2;
+			}
+			else if (lead >= 0xE0 && lead <= 0xEF) {
+				length = 3;
+				second_min = lead == 0xE0 ? 0xA0 : 0x80;
+				second_max = lead == 0xED ? 0x9F : 0xBF;
+			}
+			else if (lead >= 0xF0 && lead <= 0xF4) {
+				length = 4;
+				second_min = lead == 0xF0 ? 0x90 : 0x80;
+				second_max = lead == 0xF4 ? 0x8F : 0xBF;
+			}
+			if (length == 0 || data.size() - i < length || bytes[i + 1] < second_min || bytes[i + 1] > second_max) {
+				return i;
+			}
+			for (std::size_t k = 2; k < length; ++k) {
+				if ((bytes[i + k] & 0xC0) != 0x80) {
+					return i;
+				}
+			}
+			i += length;
+		}
+		return std::string_view::npos;
+	}
+
+	class Utf8Error final : public std::runtime_error {
+
+	public:
+		explicit Utf8Error(const std::size_t offset) : std::runtime_error{"Invalid UTF-8 at byte " + std::to_string(offset)}, offset_{offset} {}
+
+		// The offset of the first ill-formed byte from the start of the input.
+		[[nodiscard]] std::size_t Offset() const noexcept { return offset_; }
+
+	private:
+		std::size_t offset_;
+	};
+
+	enum class LineEnding {
+		kLf,    // records end with '\n'
+		kCrLf,  // records end with "\r\n"; a trailing '\r' is removed from each record
+		kCr,    // records end with '\r'
+		kAny    // records end with either '\n' or '\r'
+	};
+
+	// A dialect known at compile time. Each dialect instantiates its own scanning kernel with these values folded in.
+	// When ValidateUtf8 is set, each record is checked as it is found and ill-formed UTF-8 throws a Utf8Error.
+	template <char Delimiter = ',', char Quote = '"', char Escape = Quote, bool Trim = true, LineEnding Ending = LineEnding::kLf,
+		bool ValidateUtf8 = false>
+	struct Dialect {
+		static constexpr char delimiter = Delimiter;
+		static constexpr char quote = Quote;  // '\0' disables quoting
+		static constexpr char escape = Escape;
+		static constexpr bool trim = Trim;
+		static constexpr LineEnding line_ending = Ending;
+		static constexpr bool validate_utf8 = ValidateUtf8;
+	};
+
+	using CsvDialect = Dialect<>;
+	using TsvDialect = Dialect<'\t'>;
+	using PipeDialect = Dialect<'|'>;
+	using Utf8CsvDialect = Dialect<',', '"', '"', true, LineEnding::kLf, true>;
+
+	// A dialect only known at runtime, e.g. when it is configured or inferred from the input.
+	struct RuntimeDialect {
+		char delimiter = ',';
+		char quote = '"';  // '\0' disables quoting
+		char escape = '"';
+		bool trim = true;
+		LineEnding line_ending = LineEnding::kLf;
+		bool validate_utf8 = false;
+	};
+
+	template <typename DialectType> class Tokenizer {
+
+	public:
+		static constexpr auto npos = std::string_view::npos;
+
+		explicit Tokenizer(const DialectType& dialect = {}) noexcept : dialect_{dialect} {}
+
+		// Extracts the next non-empty record at or after position. Unless final is set, an unterminated record is left in
+		// place since the remainder may not have been read yet. Position is advanced past each record consumed. When the
+		// dialect validates UTF-8, the Utf8Error offset is relative to data.
+		bool NextRecord(const std::string_view data, std::size_t& position, std::string_view& record, const bool final) const {
+			while (position < data.size()) {
+				const auto remaining = data.substr(position);
+				auto end = FindRecordEnd(remaining);
+
+				if (end == npos) {
+					if (!final) {
+						return false;
+					}
+					end = remaining.size();
+					position = data.size();
+				}
+				else {
+					position += end + 1;
+				}
+
+				auto candidate = remaining.substr(0, end);
+				if (dialect_.line_ending == LineEnding::kCrLf && !candidate.empty() && candidate.back() == '\r') {
+					candidate.remove_suffix(1);
+				}
+				if (!candidate.empty()) {
+					if (dialect_.validate_utf8) {
+						if (const auto error = FindInvalidUtf8(candidate); error != npos) {
+							throw Utf8Error{static_cast<std::size_t>(candidate.data() - data.data()) + error};
+						}
+					}
+					record = candidate;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// Splits a record into fields, removing enclosing quotes and escapes. Fields remain valid until the next call.
+		const std::vector<std::string_view>& Split(const std::string_view record) {
+			fields_.clear();
+			scratch_.clear();
+			scratch_.reserve(record.size());
+
+			for (std::size_t position = 0; position != npos;) {
+				fields_.push_back(NextField(record, position));
+			}
+
+			return fields_;
+		}
+
+		[[nodiscard]] const DialectType& Dialect() const noexcept { return dialect_; }
+
+	private:
+		[[nodiscard]] bool IsRecordSeparator(const char c) const noexcept {
+			switch (dialect_.line_ending) {
+				case LineEnding::kCr: return c == '\r';
+				case LineEnding::kAny: return c == '\n' || c == '\r';
+				default: return c == '\n';
+			}
+		}
+
+		[[nodiscard]] bool IsWhitespace(const char c) const noexcept {
+			return (c == ' ' || c == '\t' || c == '\r') && c != dialect_.delimiter;
+		}
+
+		[[nodiscard]] std::size_t FindSeparator(const std::string_view data, const std::size_t position) const noexcept {
+			switch (dialect_.line_ending) {
+				case LineEnding::kCr: return data.find('\r', position);
+				case LineEnding::kAny: return data.find_first_of("\r\n", position);
+				default: return data.find('\n', position);
+			}
+		}
+
+		[[nodiscard]] std::size_t FindClosingQuote(const std::string_view data, std::size_t position) const noexcept {
+			for (; position < data.size(); ++position) {
+				if (dialect_.escape != dialect_.quote && data[position] == dialect_.escape) {
+					++position;
+				}
+				else if (data[position] == dialect_.quote) {
+					if (dialect_.escape != dialect_.quote || position + 1 == data.size() || data[position + 1] != dialect_.quote) {
+						return position;
+					}
+					++position;
+				}
+			}
+			return npos;
+		}
+
+		// A quote only opens a quoted field as its first character, after any whitespace that is trimmed, as in NextField.
+		[[nodiscard]] bool IsFieldStart(const std::string_view record, std::size_t position) const noexcept {
+			if (dialect_.trim) {
+				while (position != 0 && IsWhitespace(record[position - 1])) {
+					--position;
+				}
+			}
+			return position == 0 || record[position - 1] == dialect_.delimiter;
+		}
+
+		// Record separators inside quoted fields do not end the record, so the search resumes after each closing quote.
+		[[nodiscard]] std::size_t FindRecordEnd(const std::string_view data) const noexcept {
+			auto end = FindSeparator(data, 0);
+			if (dialect_.quote == '\0') {
+				return end;
+			}
+
+			// Quotes are only searched for up to the separator, so unquoted records do not scan the rest of the input.
+			for (auto quote = data.substr(0, end).find(dialect_.quote); quote != npos;) {
+				if (!IsFieldStart(data, quote)) {
+					quote = data.substr(0, end).find(dialect_.quote, quote + 1);
+					continue;
+				}
+				const auto closing = FindClosingQuote(data, quote + 1);
+				if (closing == npos) {
+					return npos;
+				}
+				end = FindSeparator(data, closing + 1);
+				quote = data.substr(0, end).find(dialect_.quote, closing + 1);
+			}
+
+			return end;
+		}
+
+		std::string_view NextField(const std::string_view record, std::size_t& position) {
+			auto begin = position;
+			if (dialect_.trim) {
+				while (begin < record.size() && IsWhitespace(record[begin])) {
+					++begin;
+				}
+			}
+
+			if (dialect_.quote != '\0' && begin < record.size() && record[begin] == dialect_.quote) {
+				return NextQuotedField(record, begin + 1, position);
+			}
+
+			const auto end = record.find(dialect_.delimiter, begin);
+			position = end == npos ? npos : end + 1;
+
+			auto field = record.substr(begin, (end == npos ? record.size() : end) - begin);
+			if (dialect_.trim) {
+				while (!field.empty() && IsWhitespace(field.back())) {
+					field.remove_suffix(1);
+				}
+			}
+			return field;
+		}
+
+		std::string_view NextQuotedField(const std::string_view record, const std::size_t begin, std::size_t& position) {
+			const auto closing = FindClosingQuote(record, begin);
+			if (closing == npos) {
+				throw std::runtime_error{"Unterminated quoted field"};
+			}
+
+			const auto unescaped_begin = scratch_.size();
+			for (auto i = begin; i < closing; ++i) {
+				if (record[i] == dialect_.escape && i + 1 < closing) {
+					++i;
+				}
+				scratch_.push_back(record[i]);
+			}
+
+			auto after = closing + 1;
+			if (dialect_.trim) {
+				while (after < record.size() && IsWhitespace(record[after])) {
+					++after;
+				}
+			}
+			if (after == record.size()) {
+				position = npos;
+			}
+			else if (record[after] == dialect_.delimiter) {
+				position = after + 1;
+			}
+			else {
+				throw std::runtime_error{"Unexpected character after quoted field"};
+			}
+
+			return std::string_view{scratch_}.substr(unescaped_begin);
+		}
+
+		DialectType dialect_;
+		std::vector<std::string_view> fields_;
+		std::string scratch_;
+	};
+
+	// Hooks invoked while a table is parsed. Observers derive from this and hide the hooks they need. Calls are resolved at
+	// compile time, so hooks left empty cost nothing and tables parsed without an observer are not instrumented at all.
+	struct ParseObserver {
+		// RowMilestone is invoked each time this many rows have been parsed, or never when zero.
+		static constexpr std::size_t kMilestoneRows = 0;
+
+		// Brackets a whole parse, named "parse" when a table is constructed and "append" when records are appended.
+		void BeginPhase(const char* /*name*/) noexcept {}
+		void EndPhase(const char* /*name*/) noexcept {}
+
+		// Brackets each read of a chunk of input from the source.
+		void BeginChunk() noexcept {}
+		void EndChunk(std::size_t /*bytes*/) noexcept {}
+
+		// Brackets locating the next record and splitting it into fields. EndScan is skipped once the input is exhausted.
+		void BeginScan() noexcept {}
+		void EndScan(std::size_t /*bytes*/, std::size_t /*field_count*/) noexcept {}
+
+		// Brackets converting one field and appending it to the column storage.
+		void BeginField(std::size_t /*column_index*/) noexcept {}
+		template <typename Storage> void EndField(std::size_t /*column_index*/, const Storage& /*column*/) noexcept {}
+
+		void RowMilestone(std::size_t /*row_count*/) noexcept {}
+
+		// Invoked before an exception thrown while parsing row_index propagates. The phase is ended afterwards.
+		void Error(std::size_t /*row_index*/, const std::exception& /*error*/) noexcept {}
+	};
+
+	template <typename DialectType = CsvDialect> class RecordReader {
+
+	public:
+		static constexpr std::size_t kDefaultBufferSize = 1 << 16;
+
+		explicit RecordReader(InputSource& source, const std::size_t buffer_size = kDefaultBufferSize, const DialectType& dialect = {})
+			: source_{&source}, buffer_(std::max<std::size_t>(buffer_size, 1)), tokenizer_{dialect} {}
+
+		// Reads records directly out of data without copying it.
+		explicit RecordReader(const std::string_view data, const DialectType& dialect = {})
+			: data_{data.data()}, end_{data.size()}, exhausted_{true}, tokenizer_{dialect} {}
+
+		// Advances to the next non-empty record. The view remains valid until the next call.
+		bool Next(std::string_view& record) {
+			ParseObserver observer;
+			return Next(record, observer);
+		}
+
+		// As Next, reporting each read from the source to observer as a chunk.
+		template <typename Observer> bool Next(std::string_view& record, Observer& observer) {
+			if (!started_) {
+				SkipBom(observer);
+			}
+			for (;;) {
+				const std::string_view pending{data_ + begin_, end_ - begin_};
+				std::size_t position = 0;
+				bool found;
+				try {
+					found = tokenizer_.NextRecord(pending, position, record, exhausted_);
+				}
+				catch (const Utf8Error& error) {
+					throw Utf8Error{consumed_ + error.Offset()};
+				}
+				begin_ += position;
+				consumed_ += position;
+
+				if (found) {
+					return true;
+				}
+				if (exhausted_) {
+					return false;
+				}
+				Refill(observer);
+			}
+		}
+
+		// The number of bytes consumed so far, including line endings, skipped empty records and any byte order mark.
+		[[nodiscard]] std::size_t Consumed() const noexcept { return consumed_; }
+
+		// Whether the input began with a UTF-8 byte order mark, which is skipped. Known once the first record is read.
+		[[nodiscard]] bool SkippedBom() const noexcept { return skipped_bom_; }
+
+	private:
+		template <typename Observer> void SkipBom(Observer& observer) {
+			while (end_ - begin_ < kUtf8Bom.size() && !exhausted_) {
+				Refill(observer);
+			}
+			skipped_bom_ = HasUtf8Bom({data_ + begin_, end_ - begin_});
+			if (skipped_bom_) {
+				begin_ += kUtf8Bom.size();
+				consumed_ += kUtf8Bom.size();
+			}
+			started_ = true;
+		}
+
+		template <typename Observer> void Refill(Observer& observer) {
+			if (begin_ != 0) {
+				std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+				end_ -= begin_;
+				begin_ = 0;
+			}
+			if (end_ == buffer_.size()) {
+				buffer_.resize(buffer_.size() * 2);
+			}
+			data_ = buffer_.data();
+			observer.BeginChunk();
+			const auto count = source_->Read(buffer_.data() + end_, buffer_.size() - end_);
+			observer.EndChunk(count);
+			end_ += count;
+			exhausted_ = count == 0;
+		}
+
+		InputSource* source_ = nullptr;
+		std::vector<char> buffer_;
+		const char* data_ = nullptr;
+		std::size_t begin_ = 0;
+		std::size_t end_ = 0;
+		std::size_t consumed_ = 0;
+		bool exhausted_ = false;
+		bool started_ = false;
+		bool skipped_bom_ = false;
+		Tokenizer<DialectType> tokenizer_;
+	};
+
+	// Records where the time and memory of a parse go: bytes scanned, rows and fields seen, time spent locating and
+	// splitting records versus converting fields, and the growth of each column's storage.
+	class ParseStatistics : public ParseObserver {
+
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		struct ColumnStatistics {
+			std::size_t fields = 0;
+			Clock::duration conversion_time{};
+			// Times the column storage's capacity grew while converting this column, and the bytes by which it grew. Values
+			// appended within the existing capacity are not counted.
+			std::size_t capacity_growths = 0;
+			std::size_t grown_bytes = 0;
+		};
+
+		void BeginScan() noexcept { scan_start_ = Clock::now(); }
+
+		void EndScan(const std::size_t bytes, const std::size_t field_count) noexcept {
+			scan_time_ += Clock::now() - scan_start_;
+			bytes_scanned_ += bytes;
+			fields_ += field_count;
+			++rows_;
+		}
+
+		void BeginField(std::size_t /*column_index*/) noexcept { field_start_ = Clock::now(); }
+
+		template <typename Storage> void EndField(const std::size_t column_index, const Storage& column) {
+			const auto elapsed = Clock::now() - field_start_;
+			if (column_index >= columns_.size()) {
+				columns_.resize(column_index + 1);
+				storage_bytes_.resize(column_index + 1);
+			}
+			auto& statistics = columns_[column_index];
+			++statistics.fields;
+			statistics.conversion_time += elapsed;
+
+			// A homogeneous table appends every column to the same storage, so a field stored where the previous one was is
+			// compared with that field's usage rather than with its own column's.
+			const auto previous_bytes = &column == previous_storage_ ? previous_bytes_ : storage_bytes_[column_index];
+			const auto bytes = ColumnMemoryUsage(column);
+			if (bytes > previous_bytes) {
+				++statistics.capacity_growths;
+				statistics.grown_bytes += bytes - previous_bytes;
+			}
+			storage_bytes_[column_index] = bytes;
+			previous_storage_ = &column;
+			previous_bytes_ = bytes;
+		}
+
+		[[nodiscard]] std::size_t BytesScanned() const noexcept { return bytes_scanned_; }
+		[[nodiscard]] std::size_t Rows() const noexcept { return rows_; }
+		[[nodiscard]] std::size_t Fields() const noexcept { return fields_; }
+		[[nodiscard]] Clock::duration ScanTime() const noexcept { return scan_time_; }
+
+		[[nodiscard]] Clock::duration ConversionTime() const noexcept {
+			return std::accumulate(columns_.begin(), columns_.end(), Clock::duration{},
+				[](const auto total, const auto& column) { return total + column.conversion_time; });
+		}
+
+		[[nodiscard]] std::size_t CapacityGrowths() const noexcept {
+			return std::accumulate(columns_.begin(), columns_.end(), std::size_t{0},
+				[](const auto total, const auto& column) { return total + column.capacity_growths; });
+		}
+
+		[[nodiscard]] std::size_t GrownBytes() const noexcept {
+			return std::accumulate(columns_.begin(), columns_.end(), std::size_t{0},
+				[](const auto total, const auto& column) { return total + column.grown_bytes; });
+		}
+
+		// Indexed by column; fields past the last column of a homogeneous table's widest row never appear.
+		[[nodiscard]] const std::vector<ColumnStatistics>& Columns() const noexcept { return columns_; }
+
+	private:
+		std::size_t bytes_scanned_ = 0;
+		std::size_t rows_ = 0;
+		std::size_t fields_ = 0;
+		Clock::duration scan_time_{};
+		Clock::time_point scan_start_;
+		Clock::time_point field_start_;
+		std::vector<ColumnStatistics> columns_;
+		// The storage usage seen after each column's last field.
+		std::vector<std::size_t> storage_bytes_;
+		const void* previous_storage_ = nullptr;
+		std::size_t previous_bytes_ = 0;
+	};
+
+	// Writes parse activity as Chrome trace events for chrome://tracing or Perfetto. Phases and reads of input chunks become
+	// spans, row milestones a counter and errors instant events. The trace is completed when the tracer is destroyed.
+	class ChromeTracer : public ParseObserver {
+
+	public:
+		static constexpr std::size_t kMilestoneRows = 1 << 16;
+
+		explicit ChromeTracer(std::ostream& output) : output_{&output} { *output_ << "{\"traceEvents\":["; }
+
+		explicit ChromeTracer(const std::string& path) : file_{path, std::ios::binary}, output_{&file_} {
+			if (!file_) {
+				throw std::runtime_error{"Unable to open " + path};
+			}
+			*output_ << "{\"traceEvents\":[";
+		}
+
+		ChromeTracer(const ChromeTracer&) = delete;
+		ChromeTracer& operator=(const ChromeTracer&) = delete;
+
+		~ChromeTracer() { *output_ << "]}\n" << std::flush; }
+
+		void BeginPhase(const char* const name) { Write(name, 'B'); }
+		void EndPhase(const char* const name) { Write(name, 'E'); }
+		void BeginChunk() { Write("read", 'B'); }
+		void EndChunk(const std::size_t bytes) { Write("read", 'E', "\"bytes\":" + std::to_string(bytes)); }
+		void RowMilestone(const std::size_t row_count) { Write("rows", 'C', "\"rows\":" + std::to_string(row_count)); }
+
+		void Error(const std::size_t row_index, const std::exception& error) {
+			Write("error", 'i', "\"row\":" + std::to_string(row_index) + ",\"message\":" + Quote(error.what()));
+		}
+
+	private:
+		// Events from several threads are serialized, and each thread is numbered in order of its first event.
+		void Write(const std::string_view name, const char phase, const std::string& arguments = {}) {
+			const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count();
+			std::lock_guard lock{mutex_};
+
+			const auto thread = std::find(threads_.begin(), threads_.end(), std::this_thread::get_id());
+			const auto thread_index = static_cast<std::size_t>(thread - threads_.begin());
+			if (thread == threads_.end()) {
+				threads_.push_back(std::this_thread::get_id());
+			}
+
+			*output_ << (event_count_++ == 0 ? "" : ",") << "\n{\"name\":" << Quote(name) << ",\"cat\":\"csv\",\"ph\":\"" << phase
+				<< "\",\"ts\":" << elapsed / 1000 << '.' << std::to_string(1000 + elapsed % 1000).substr(1) << ",\"pid\":1,\"tid\":"
+				<< thread_index + 1;
+			if (phase == 'i') {
+				*output_ << ",\"s\":\"t\"";
+			}
+			if (!arguments.empty()) {
+				*output_ << ",\"args\":{" << arguments << '}';
+			}
+			*output_ << '}';
+		}
+
+		static std::string Quote(const std::string_view value) {
+			constexpr char kHexDigits[] = "0123456789abcdef";
+			std::string quoted{'"'};
+			for (const auto c : value) {
+				if (c == '"' || c == '\\') {
+					quoted += '\\';
+					quoted += c;
+				}
+				else if (static_cast<unsigned char>(c) < 0x20) {
+					quoted += "\\u00";
+					quoted += kHexDigits[c >> 4];
+					quoted += kHexDigits[c & 0xF];
+				}
+				else {
+					quoted += c;
+				}
+			}
+			return quoted += '"';
+		}
+
+		std::ofstream file_;
+		std::ostream* output_;
+		const std::chrono::steady_clock::time_point start_ = std::chrono::steady_clock::now();
+		std::mutex mutex_;
+		std::vector<std::thread::id> threads_;
+		std::size_t event_count_ = 0;
+	};
+
+	class CsvBase {
+
+		template <typename T> struct IsOptional : std::false_type {};
+		template <typename T> struct IsOptional<std::optional<T>> : std::true_type {};
+
+	protected:
+		CsvBase() = default;
+
+		// Parses records until next_record returns false, reporting the phase, scans, row milestones and errors to observer.
+		// next_record also sets the number of bytes it consumed.
+		template <typename DialectType, typename Observer, typename NextRecord, typename ParseRecord>
+		static void ParseRecords(const char* const phase, Tokenizer<DialectType>& tokenizer, Observer& observer, std::size_t row_count,
+			const NextRecord& next_record, const ParseRecord& parse_record) {
+
+			observer.BeginPhase(phase);
+			try {
+				for (std::string_view record;;) {
+					observer.BeginScan();
+					std::size_t bytes = 0;
+					if (!next_record(record, bytes)) {
+						break;
+					}
+					const auto& fields = tokenizer.Split(record);
+					observer.EndScan(bytes, fields.size());
+					parse_record(fields);
+
+					++row_count;
+					if constexpr (Observer::kMilestoneRows != 0) {
+						if (row_count % Observer::kMilestoneRows == 0) {
+							observer.RowMilestone(row_count);
+						}
+					}
+				}
+			}
+			catch (const std::exception& error) {
+				observer.Error(row_count, error);
+				observer.EndPhase(phase);
+				throw;
+			}
+			observer.EndPhase(phase);
+		}
+
+		// Empty tokens are null for std::optional columns and missing values otherwise.
+		template <typename T> static T ParseToken(const std::string_view token) {
+			if constexpr (IsOptional<T>::value) {
+				if (token.empty()) {
+					return std::nullopt;
+				}
+				return ParseValue<typename T::value_type>(token);
+			}
+			else {
+				if (token.empty() && !std::is_same<T, std::string>::value && !std::is_same<T, Dictionary>::value) {
+					throw std::runtime_error{"Missing value"};
+				}
+				return ParseValue<T>(token);
+			}
+		}
+
+		template <typename T> static T ParseValue(const std::string_view token) {
+			if constexpr (std::is_same<T, bool>::value) {
+				if (const auto value = ParseBool(token)) {
+					return *value;
+				}
+			}
+			else if constexpr (std::is_same<T, char>::value) {
+				if (token.size() == 1) {
+					return token.front();
+				}
+			}
+			else if constexpr (std::is_same<T, std::string>::value) {
+				return std::string{token};
+			}
+			else if constexpr (std::is_same<T, Dictionary>::value) {
+				return Dictionary{token};
+			}
+			else if constexpr (std::is_same<T, Date>::value) {
+				if (const auto date = ParseDate(token)) {
+					return *date;
+				}
+			}
+			else if constexpr (IsDecimal<T>::value) {
+				if (const auto decimal = T::Parse(token)) {
+					return *decimal;
+				}
+			}
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+			else if constexpr (std::is_arithmetic<T>::value) {
+#else
+			else if constexpr (std::is_integral<T>::value) {
+#endif
+				const auto first = token.data() + ExplicitPlusLength(token);
+				const auto last = token.data() + token.size();
+				T element{};
+				if (const auto [end, error] = std::from_chars(first, last, element); end == last && error == std::errc{}) {
+					return element;
+				}
+			}
+			else {
+				if (T element; std::istringstream{std::string{token}} >> element) {
+					return element;
+				}
+			}
+			throw std::runtime_error{"Invalid value: " + std::string{token}};
+		}
+
+		// Recognizes true/false/t/f/1/0 in any letter case. Words are compared whole in a 64-bit register after setting the
+		// ASCII case bit on every letter position; only upper or lower case letters map onto the lower case pattern.
+		static std::optional<bool> ParseBool(const std::string_view token) noexcept {
+			constexpr auto pack = [](const std::string_view word) constexpr {
+				std::uint64_t packed = 0;
+				for (std::size_t i = 0; i < word.size(); ++i) {
+					packed |= std::uint64_t{static_cast<unsigned char>(word[i])} << (8 * i);
+				}
+				return packed;
+			};
+			constexpr std::uint64_t kLowerCase = 0x2020202020;
+
+			switch (token.size()) {
+				case 1:
+					switch (token.front()) {
+						case '1': case 't': case 'T': return true;
+						case '0': case 'f': case 'F': return false;
+						default: return std::nullopt;
+					}
+				case 4:
+					if ((pack(token) | (kLowerCase >> 8)) == pack("true")) {
+						return true;
+					}
+					return std::nullopt;
+				case 5:
+					if ((pack(token) | kLowerCase) == pack("false")) {
+						return false;
+					}
+					return std::nullopt;
+				default:
+					return std::nullopt;
+			}
+		}
+
+		// from_chars rejects a leading '+' but accepts '-', so a plus is skipped only when no second sign follows it.
+		static std::size_t ExplicitPlusLength(const std::string_view token) noexcept {
+			return token.size() > 1 && token[0] == '+' && token[1] != '+' && token[1] != '-' ? 1 : 0;
+		}
+
+		static std::optional<Date> ParseDate(const std::string_view token) noexcept {
+			const auto digits = [&](const std::size_t offset, const std::size_t count, unsigned& value) {
+				const auto [end, error] = std::from_chars(token.data() + offset, token.data() + offset + count, value);
+				return error == std::errc{} && end == token.data() + offset + count;
+			};
+
+			unsigned year = 0, month = 0, day = 0;
+			if (token.size() != 10 || token[4] != '-' || token[7] != '-' || !digits(0, 4, year) || !digits(5, 2, month) || !digits(8, 2, day)) {
+				return std::nullopt;
+			}
+
+			constexpr unsigned kDaysInMonth[] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+			const auto leap_year = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+			if (month < 1 || month > 12 || day < 1 || day > kDaysInMonth[month - 1] || (month == 2 && day == 29 && !leap_year)) {
+				return std::nullopt;
+			}
+
+			return Date::FromCivil(static_cast<std::int32_t>(year), month, day);
+		}
+
+		static void CheckRange(const std::size_t first, const std::size_t count, const std::size_t size) {
+			if (first > size || count > size - first) {
+				throw std::runtime_error{"Index out of bounds"};
+			}
+		}
+
+		// Fields missing from the end of a record are treated as empty.
+		[[nodiscard]] static std::string_view FieldAt(const std::vector<std::string_view>& fields, const std::size_t index) noexcept {
+			return index < fields.size() ? fields[index] : std::string_view{};
+		}
+	};
+
+	template <typename DialectType, typename... ColumnTypes> class BasicCsv final : public CsvBase {
+
+		using Columns = std::tuple<typename ColumnTraits<ColumnTypes>::Storage...>;
+
+		template <std::size_t ColumnIndex>
+		using ColumnType = typename std::tuple_element<ColumnIndex, std::tuple<ColumnTypes...>>::type;
+
+		template <typename TargetType, std::size_t CurrentIndex = sizeof...(ColumnTypes)>
+		struct ColumnAtIndex {
+			static typename ColumnTraits<TargetType>::Reference Get(
+				const Columns& columns, const std::size_t row_index, const std::size_t column_index) {
+
+				if constexpr (CurrentIndex == 0) {
+					throw std::runtime_error{"Index out of bounds"};
+				}
+				else {
+					if (column_index == CurrentIndex - 1) {
+						if constexpr (std::is_same<TargetType, ColumnType<CurrentIndex - 1>>::value) {
+							return std::get<CurrentIndex - 1>(columns)[row_index];
+						}
+						else {
+							throw std::runtime_error{"Tuple element type mismatch"};
+						}
+					}
+					return ColumnAtIndex<TargetType, CurrentIndex - 1>::Get(columns, row_index, column_index);
+				}
+			}
+		};
+
+	public:
+		class Row {
+
+		public:
+			Row(const BasicCsv* const csv, const std::size_t index) noexcept : csv_{csv}, index_{index} {}
+
+			template <std::size_t ColumnIndex>
+			[[nodiscard]] typename ColumnTraits<ColumnType<ColumnIndex>>::Reference Get() const {
+				return std::get<ColumnIndex>(csv_->columns_)[index_];
+			}
+
+			template <typename T>
+			[[nodiscard]] typename ColumnTraits<T>::Reference Get(const std::size_t column_index) const {
+				return ColumnAtIndex<T>::Get(csv_->columns_, index_, column_index);
+			}
+
+			[[nodiscard]] std::size_t Index() const noexcept { return index_; }
+
+		private:
+			const BasicCsv* csv_;
+			std::size_t index_;
+		};
+
+		using RowType = Row;
+		using Iterator = RowIterator<BasicCsv>;
+
+		explicit BasicCsv(const std::string_view data, const DialectType& dialect = {}) : BasicCsv{data, dialect, ParseObserver{}} {}
+		explicit BasicCsv(InputSource& source, const DialectType& dialect = {}) : BasicCsv{source, dialect, ParseObserver{}} {}
+
+		// Reports parse events to observer, such as a ParseStatistics.
+		template <typename Observer> BasicCsv(const std::string_view data, const DialectType& dialect, Observer&& observer) : dialect_{dialect} {
+			RecordReader<DialectType> records{data, dialect};
+			ParseRecords(records, dialect, observer);
+		}
+
+		template <typename Observer> BasicCsv(InputSource& source, const DialectType& dialect, Observer&& observer) : dialect_{dialect} {
+			RecordReader<DialectType> records{source, RecordReader<DialectType>::kDefaultBufferSize, dialect};
+			ParseRecords(records, dialect, observer);
+		}
+
+		// Parses the records in data and appends them as rows. Unless final, a trailing record which may be incomplete is
+		// left unparsed. Returns the number of bytes consumed. If any record fails to parse, the table is left unchanged.
+		std::size_t Append(const std::string_view data, const bool final = true) { return Append(data, final, ParseObserver{}); }
+
+		template <typename Observer> std::size_t Append(const std::string_view data, const bool final, Observer&& observer) {
+			Tokenizer<DialectType> tokenizer{dialect_};
+			std::size_t position = 0;
+			const auto next_record = [&](std::string_view& record, std::size_t& bytes) {
+				const auto start = position;
+				const auto found = tokenizer.NextRecord(data, position, record, final);
+				bytes = position - start;
+				return found;
+			};
+			const auto row_count = RowCount();
+			try {
+				CsvBase::ParseRecords("append", tokenizer, observer, row_count, next_record, [&](const auto& fields) { ParseRecord(fields, observer); });
+			}
+			catch (...) {
+				Truncate(row_count, std::index_sequence_for<ColumnTypes...>{});
+				throw;
+			}
+			return position;
+		}
+
+		template <typename ColumnType>
+		[[nodiscard]] typename ColumnTraits<ColumnType>::Reference Get(const std::size_t row_index, const std::size_t column_index) const {
+			if (row_index >= RowCount()) {
+				throw std::runtime_error{"Index out of bounds"};
+			}
+			return ColumnAtIndex<ColumnType>::Get(columns_, row_index, column_index);
+		}
+
+		template <std::size_t ColumnIndex>
+		[[nodiscard]] typename ColumnTraits<ColumnType<ColumnIndex>>::View Column() const {
+			return ColumnTraits<ColumnType<ColumnIndex>>::MakeView(std::get<ColumnIndex>(columns_));
+		}
+
+		[[nodiscard]] Row operator[](const std::size_t row_index) const {
+			CheckRange(row_index, 1, RowCount());
+			return RowAt(row_index);
+		}
+
+		[[nodiscard]] RowRange<Iterator> Rows(const std::size_t first, const std::size_t count) const {
+			CheckRange(first, count, RowCount());
+			return {Iterator{this, first}, Iterator{this, first + count}};
+		}
+
+		[[nodiscard]] Iterator begin() const noexcept { return {this, 0}; }
+		[[nodiscard]] Iterator end() const noexcept { return {this, RowCount()}; }
+
+		[[nodiscard]] std::size_t RowCount() const noexcept {
+			if constexpr (sizeof...(ColumnTypes) == 0) {
+				return 0;
+			}
+			else {
+				return std::get<0>(columns_).size();
+			}
+		}
+
+		[[nodiscard]] static constexpr std::size_t ColumnCount() noexcept { return sizeof...(ColumnTypes); }
+
+		// Approximate heap bytes held by the parsed columns.
+		[[nodiscard]] std::size_t MemoryUsage() const noexcept {
+			return std::apply([](const auto&... columns) { return (std::size_t{0} + ... + ColumnMemoryUsage(columns)); }, columns_);
+		}
+
+		// A stable permutation of the rows ordered by the given columns, the first of which is the most significant.
+		template <std::size_t... SortColumns> [[nodiscard]] std::vector<std::size_t> SortedOrder() const {
+			static_assert(sizeof...(SortColumns) > 0, "At least one sort column is required");
+			std::vector<std::size_t> order(RowCount());
+			std::iota(order.begin(), order.end(), std::size_t{0});
+			SortBy<SortColumns...>(order);
+			return order;
+		}
+
+		// Reorders the rows of every column by the given columns, as SortedOrder does.
+		template <std::size_t... SortColumns> void Sort() {
+			const auto order = SortedOrder<SortColumns...>();
+			PermuteColumns(order, std::index_sequence_for<ColumnTypes...>{});
+		}
+
+	private:
+		friend class RowIterator<BasicCsv>;
+
+		[[nodiscard]] Row RowAt(const std::size_t row_index) const noexcept { return {this, row_index}; }
+
+		// Sorts by the least significant column first, relying on each pass being stable.
+		template <std::size_t SortColumn, std::size_t... SortColumns> void SortBy(std::vector<std::size_t>& order) const {
+			if constexpr (sizeof...(SortColumns) > 0) {
+				SortBy<SortColumns...>(order);
+			}
+			SortRowsByColumn(order, std::get<SortColumn>(columns_));
+		}
+
+		template <std::size_t... ColumnIndices>
+		void PermuteColumns(const std::vector<std::size_t>& order, std::index_sequence<ColumnIndices...>) {
+			((std::get<ColumnIndices>(columns_) = PermuteColumn(std::get<ColumnIndices>(columns_), order)), ...);
+		}
+
+		// Restores every column to row_count values, including columns a failed record had already been appended to.
+		template <std::size_t... ColumnIndices> void Truncate(const std::size_t row_count, std::index_sequence<ColumnIndices...>) {
+			(TruncateColumn(std::get<ColumnIndices>(columns_), row_count), ...);
+		}
+
+		template <typename Observer> void ParseRecords(RecordReader<DialectType>& records, const DialectType& dialect, Observer& observer) {
+			Tokenizer<DialectType> tokenizer{dialect};
+			const auto next_record = [&](std::string_view& record, std::size_t& bytes) {
+				const auto consumed = records.Consumed();
+				const auto found = records.Next(record, observer);
+				bytes = records.Consumed() - consumed;
+				return found;
+			};
+			CsvBase::ParseRecords("parse", tokenizer, observer, 0, next_record, [&](const auto& fields) { ParseRecord(fields, observer); });
+		}
+
+		template <typename Observer> void ParseRecord(const std::vector<std::string_view>& fields, Observer& observer) {
+			ParseFields(fields, observer, std::index_sequence_for<ColumnTypes...>{});
+		}
+
+		template <typename Observer, std::size_t... ColumnIndices>
+		void ParseFields(const std::vector<std::string_view>& fields, Observer& observer, std::index_sequence<ColumnIndices...>) {
+			(ParseField<ColumnIndices>(fields, observer), ...);
+		}
+
+		template <std::size_t ColumnIndex, typename Observer> void ParseField(const std::vector<std::string_view>& fields, Observer& observer) {
+			auto& column = std::get<ColumnIndex>(columns_);
+			observer.BeginField(ColumnIndex);
+			AppendField<ColumnType<ColumnIndex>>(column, FieldAt(fields, ColumnIndex));
+			observer.EndField(ColumnIndex, column);
+		}
+
+		// String fields are copied straight from the record into the column's byte buffer.
+		template <typename T, typename Storage> static void AppendField(Storage& column, const std::string_view field) {
+			if constexpr (std::is_same<T, std::string>::value) {
+				column.push_back(field);
+			}
+			else {
+				column.push_back(ParseToken<T>(field));
+			}
+		}
+
+		DialectType dialect_;
+		Columns columns_;
+	};
+
+	// A growable array which, unlike std::vector<bool>, keeps every element type addressable as a contiguous span.
+	template <typename T> class ContiguousVector {
+
+	public:
+		using value_type = T;
+
+		void push_back(T value) {
+			if (size_ == capacity_) {
+				reserve(std::max<std::size_t>(capacity_ * 2, 16));
+			}
+			data_[size_++] = std::move(value);
+		}
+
+		void Truncate(const std::size_t size) noexcept { size_ = size; }
+
+		void reserve(const std::size_t capacity) {
+			if (capacity > capacity_) {
+				auto data = std::make_unique<T[]>(capacity);
+				std::move(data_.get(), data_.get() + size_, data.get());
+				data_ = std::move(data);
+				capacity_ = capacity;
+			}
+		}
+
+		[[nodiscard]] const T* data() const noexcept { return data_.get(); }
+		[[nodiscard]] std::size_t size() const noexcept { return size_; }
+		[[nodiscard]] std::size_t MemoryUsage() const noexcept { return capacity_ * sizeof(T); }
+
+	private:
+		std::unique_ptr<T[]> data_;
+		std::size_t size_ = 0;
+		std::size_t capacity_ = 0;
+	};
+
+	template <typename DialectType, typename T> class BasicCsv<DialectType, T> final : public CsvBase {
+
+	public:
+		using RowType = Span<const T>;
+		using Iterator = RowIterator<BasicCsv>;
+
+		explicit BasicCsv(const std::string_view data, const DialectType& dialect = {}) : BasicCsv{data, dialect, ParseObserver{}} {}
+		explicit BasicCsv(InputSource& source, const DialectType& dialect = {}) : BasicCsv{source, dialect, ParseObserver{}} {}
+
+		// Reports parse events to observer, such as a ParseStatistics.
+		template <typename Observer> BasicCsv(const std::string_view data, const DialectType& dialect, Observer&& observer) : dialect_{dialect} {
+			RecordReader<DialectType> records{data, dialect};
+			ParseRecords(records, dialect, observer);
+		}
+
+		template <typename Observer> BasicCsv(InputSource& source, const DialectType& dialect, Observer&& observer) : dialect_{dialect} {
+			RecordReader<DialectType> records{source, RecordReader<DialectType>::kDefaultBufferSize, dialect};
+			ParseRecords(records, dialect, observer);
+		}
+
+		// Parses the records in data and appends them as rows. Unless final, a trailing record which may be incomplete is
+		// left unparsed. Returns the number of bytes consumed. If any record fails to parse, the table is left unchanged.
+		std::size_t Append(const std::string_view data, const bool final = true) { return Append(data, final, ParseObserver{}); }
+
+		template <typename Observer> std::size_t Append(const std::string_view data, const bool final, Observer&& observer) {
+			Tokenizer<DialectType> tokenizer{dialect_};
+			std::size_t position = 0;
+			const auto next_record = [&](std::string_view& record, std::size_t& bytes) {
+				const auto start = position;
+				const auto found = tokenizer.NextRecord(data, position, record, final);
+				bytes = position - start;
+				return found;
+			};
+			const auto row_count = RowCount();
+			try {
+				CsvBase::ParseRecords("append", tokenizer, observer, row_count, next_record, [&](const auto& fields) { ParseRecord(fields, observer); });
+			}
+			catch (...) {
+				row_offsets_.resize(row_count + 1);
+				elements_.Truncate(row_offsets_.back());
+				throw;
+			}
+			return position;
+		}
+
+		[[nodiscard]] const T& Get(const std::size_t row_index, const std::size_t column_index) const {
+			if (row_index >= RowCount() || column_index >= RowAt(row_index).size()) {
+				throw std::runtime_error{"Index out of bounds"};
+			}
+			return RowAt(row_index)[column_index];
+		}
+
+		[[nodiscard]] Span<const T> operator[](const std::size_t row_index) const {
+			CheckRange(row_index, 1, RowCount());
+			return RowAt(row_index);
+		}
+
+		[[nodiscard]] RowRange<Iterator> Rows(const std::size_t first, const std::size_t count) const {
+			CheckRange(first, count, RowCount());
+			return {Iterator{this, first}, Iterator{this, first + count}};
+		}
+
+		[[nodiscard]] Iterator begin() const noexcept { return {this, 0}; }
+		[[nodiscard]] Iterator end() const noexcept { return {this, RowCount()}; }
+
+		[[nodiscard]] std::size_t RowCount() const noexcept { return row_offsets_.size() - 1; }
+
+	private:
+		friend class RowIterator<BasicCsv>;
+
+		[[nodiscard]] Span<const T> RowAt(const std::size_t row_index) const noexcept {
+			return {elements_.data() + row_offsets_[row_index], row_offsets_[row_index + 1] - row_offsets_[row_index]};
+		}
+
+		template <typename Observer> void ParseRecords(RecordReader<DialectType>& records, const DialectType& dialect, Observer& observer) {
+			Tokenizer<DialectType> tokenizer{dialect};
+			const auto next_record = [&](std::string_view& record, std::size_t& bytes) {
+				const auto consumed = records.Consumed();
+				const auto found = records.Next(record, observer);
+				bytes = records.Consumed() - consumed;
+				return found;
+			};
+			CsvBase::ParseRecords("parse", tokenizer, observer, 0, next_record, [&](const auto& fields) { ParseRecord(fields, observer); });
+		}
+
+		template <typename Observer> void ParseRecord(const std::vector<std::string_view>& fields, Observer& observer) {
+			for (std::size_t i = 0; i < fields.size(); ++i) {
+				observer.BeginField(i);
+				elements_.push_back(ParseToken<T>(fields[i]));
+				observer.EndField(i, elements_);
+			}
+			row_offsets_.push_back(elements_.size());
+		}
+
+		DialectType dialect_;
+		ContiguousVector<T> elements_;
+		std::vector<std::size_t> row_offsets_{0};
+	};
+
+	template <typename... ColumnTypes> using Csv = BasicCsv<CsvDialect, ColumnTypes...>;
+
+	template <typename DialectType, typename... ColumnTypes> class BasicRowReader final : public CsvBase {
+
+	public:
+		explicit BasicRowReader(
+			InputSource& source, const std::size_t buffer_size = RecordReader<DialectType>::kDefaultBufferSize, const DialectType& dialect = {})
+			: records_{source, buffer_size, dialect}, tokenizer_{dialect} {}
+
+		bool Next(std::tuple<ColumnTypes...>& row) {
+			std::string_view record;
+			if (!records_.Next(record)) {
+				return false;
+			}
+			ParseFields(tokenizer_.Split(record), row, std::index_sequence_for<ColumnTypes...>{});
+			return true;
+		}
+
+	private:
+		template <std::size_t... ColumnIndices>
+		static void ParseFields(
+			const std::vector<std::string_view>& fields, std::tuple<ColumnTypes...>& row, std::index_sequence<ColumnIndices...>) {
+
+			((std::get<ColumnIndices>(row) = ParseToken<ColumnTypes>(FieldAt(fields, ColumnIndices))), ...);
+		}
+
+		RecordReader<DialectType> records_;
+		Tokenizer<DialectType> tokenizer_;
+	};
+
+	template <typename... ColumnTypes> using RowReader = BasicRowReader<CsvDialect, ColumnTypes...>;
+
+#ifdef CSV_HAS_POSIX_IO
+
+	// Keeps a table up to date with a file which is only ever appended to, such as a log. Each refresh parses only the bytes
+	// appended since the last one and holds back a trailing record until it is complete. When the file is truncated or
+	// replaced, e.g. by log rotation, the table is rebuilt from the start of the current file.
+	template <typename DialectType, typename... ColumnTypes> class BasicCsvFollower {
+
+		using CsvType = BasicCsv<DialectType, ColumnTypes...>;
+
+	public:
+		explicit BasicCsvFollower(std::string path, const DialectType& dialect = {})
+			: path_{std::move(path)}, dialect_{dialect}, csv_{std::string_view{}, dialect} {
+			Refresh();
+		}
+
+		BasicCsvFollower(const BasicCsvFollower&) = delete;
+		BasicCsvFollower& operator=(const BasicCsvFollower&) = delete;
+
+		~BasicCsvFollower() {
+#ifdef CSV_HAS_INOTIFY
+			if (inotify_ != -1) {
+				::close(inotify_);
+			}
+#endif
+		}
+
+		// Parses any newly appended records and returns the number of rows added, or the row count of the rebuilt table.
+		std::size_t Refresh() {
+			if (!file_ || Replaced()) {
+				Rebuild();
+			}
+
+			auto size = file_->Size();
+			if (size < read_offset_ || Rewritten()) {
+				Rebuild();
+				size = file_->Size();
+			}
+
+			const auto row_count = csv_.RowCount();
+			const auto pending = pending_.size();
+			pending_.resize(pending + (size - read_offset_));
+			for (auto position = pending; position < pending_.size();) {
+				const auto count = ::pread(file_->Get(), pending_.data() + position, pending_.size() - position, static_cast<off_t>(read_offset_));
+				if (count == -1 && errno == EINTR) {
+					continue;
+				}
+				if (count == -1) {
+					throw std::runtime_error{"Failed to read " + path_ + ": " + std::strerror(errno)};
+				}
+				if (count == 0) {
+					pending_.resize(position);
+					break;
+				}
+				position += static_cast<std::size_t>(count);
+				read_offset_ += static_cast<std::size_t>(count);
+			}
+			const auto tail = std::min(pending_.size() - pending, kTailSize);
+			tail_.append(pending_, pending_.size() - tail, tail);
+			if (tail_.size() > kTailSize) {
+				tail_.erase(0, tail_.size() - kTailSize);
+			}
+
+			// While everything read is still pending, it may begin with a byte order mark, which can only be recognized once
+			// its three bytes have arrived.
+			if (read_offset_ == pending_.size()) {
+				if (pending_.size() < kUtf8Bom.size() && kUtf8Bom.substr(0, pending_.size()) == pending_) {
+					return 0;
+				}
+				if (HasUtf8Bom(pending_)) {
+					pending_.erase(0, kUtf8Bom.size());
+				}
+			}
+
+			pending_.erase(0, csv_.Append(pending_, false));
+			return csv_.RowCount() - row_count;
+		}
+
+		// Blocks until the file is modified, moved or deleted, or until timeout elapses, and returns whether it changed.
+		// Without inotify this sleeps for timeout and reports a possible change.
+		bool WaitForChange(const std::chrono::milliseconds timeout) {
+#ifdef CSV_HAS_INOTIFY
+			if (inotify_ == -1) {
+				inotify_ = ::inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+				if (inotify_ == -1) {
+					throw std::runtime_error{std::string{"Unable to initialize inotify: "} + std::strerror(errno)};
+				}
+				Watch();
+			}
+			if (watch_ == -1) {
+				// the file was moved away and its replacement has not been created yet
+				std::this_thread::sleep_for(timeout);
+				return true;
+			}
+
+			pollfd descriptor{inotify_, POLLIN, 0};
+			const auto ready = ::poll(&descriptor, 1, static_cast<int>(timeout.count()));
+			if (ready == -1 && errno != EINTR) {
+				throw std::runtime_error{std::string{"Failed to wait for inotify events: "} + std::strerror(errno)};
+			}
+			if (ready <= 0) {
+				// a deleted file's watch is removed, so replacements are only noticed by checking
+				return Replaced();
+			}
+
+			alignas(inotify_event) char events[4096];
+			while (::read(inotify_, events, sizeof events) > 0) {}
+			return true;
+#else
+			std::this_thread::sleep_for(timeout);
+			return true;
+#endif
+		}
+
+		[[nodiscard]] const CsvType& Table() const noexcept { return csv_; }
+
+		// The file offset just past the last complete record.
+		[[nodiscard]] std::size_t Offset() const noexcept { return read_offset_ - pending_.size(); }
+
+		// How many times the table has been rebuilt after the file was truncated or replaced.
+		[[nodiscard]] std::size_t RebuildCount() const noexcept { return rebuild_count_; }
+
+	private:
+		// The number of bytes before read_offset_ kept to notice a file truncated and written past its old size in between
+		// refreshes.
+		static constexpr std::size_t kTailSize = 64;
+
+		// Whether path now names a different file than the one open, which is kept until a replacement exists.
+		[[nodiscard]] bool Replaced() const {
+			struct stat current {}, opened {};
+			if (::stat(path_.c_str(), &current) == -1 || ::fstat(file_->Get(), &opened) == -1) {
+				return false;
+			}
+			return current.st_ino != opened.st_ino || current.st_dev != opened.st_dev;
+		}
+
+		// Whether the bytes last read no longer match the file, which means it was rewritten in place.
+		[[nodiscard]] bool Rewritten() const {
+			std::string current(tail_.size(), '\0');
+			for (std::size_t position = 0; position < current.size();) {
+				const auto offset = read_offset_ - tail_.size() + position;
+				const auto count = ::pread(file_->Get(), current.data() + position, current.size() - position, static_cast<off_t>(offset));
+				if (count == -1 && errno == EINTR) {
+					continue;
+				}
+				if (count == -1) {
+					throw std::runtime_error{"Failed to read " + path_ + ": " + std::strerror(errno)};
+				}
+				if (count == 0) {
+					return true;
+				}
+				position += static_cast<std::size_t>(count);
+			}
+			return current != tail_;
+		}
+
+		void Rebuild() {
+			if (file_) {
+				++rebuild_count_;
+			}
+			file_.reset();
+			file_.emplace(path_, O_RDONLY);
+			csv_ = CsvType{std::string_view{}, dialect_};
+			pending_.clear();
+			tail_.clear();
+			read_offset_ = 0;
+#ifdef CSV_HAS_INOTIFY
+			if (inotify_ != -1) {
+				Watch();
+			}
+#endif
+		}
+
+#ifdef CSV_HAS_INOTIFY
+		void Watch() {
+			if (watch_ != -1) {
+				::inotify_rm_watch(inotify_, watch_);
+			}
+			watch_ = ::inotify_add_watch(inotify_, path_.c_str(), IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+		}
+
+		int inotify_ = -1;
+		int watch_ = -1;
+#endif
+
+		std::string path_;
+		DialectType dialect_;
+		std::optional<FileDescriptor> file_;
+		CsvType csv_;
+		std::string pending_;
+		std::string tail_;
+		std::size_t read_offset_ = 0;
+		std::size_t rebuild_count_ = 0;
+	};
+
+	template <typename... ColumnTypes> using CsvFollower = BasicCsvFollower<CsvDialect, ColumnTypes...>;
+
+#endif
+
+	template <typename T> struct UnwrapOptional { using type = T; };
+	template <typename T> struct UnwrapOptional<std::optional<T>> { using type = T; };
+
+	// Invokes visitor with a column value unless it is null.
+	template <typename T, typename Visitor> void VisitValue(const T& value, Visitor&& visitor) { visitor(value); }
+
+	template <typename T, typename Visitor> void VisitValue(const std::optional<T>& value, Visitor&& visitor) {
+		if (value) {
+			visitor(*value);
+		}
+	}
+
+	// Column values as they compare, hash and are stored once they must outlive the row they were read from. Dictionary
+	// values compare as views and are stored as strings.
+	inline std::string_view ValueView(const Dictionary value) noexcept { return value.value; }
+	inline std::optional<std::string_view> ValueView(const std::optional<Dictionary>& value) noexcept {
+		return value ? std::optional<std::string_view>{value->value} : std::nullopt;
+	}
+	template <typename T> const T& ValueView(const T& value) noexcept { return value; }
+
+	inline std::string OwnedValue(const Dictionary value) { return std::string{value.value}; }
+	inline std::string OwnedValue(const std::string_view value) { return std::string{value}; }
+	template <typename T> T OwnedValue(const T& value) { return value; }
+
+	template <typename T> auto OwnedValue(const std::optional<T>& value) -> std::optional<decltype(OwnedValue(*value))> {
+		if (value) {
+			return OwnedValue(*value);
+		}
+		return std::nullopt;
+	}
+
+	template <typename T> std::size_t HashValue(const T& value) { return std::hash<T>{}(value); }
+	inline std::size_t HashValue(const Date value) { return std::hash<std::int32_t>{}(value.days_since_epoch); }
+
+	template <unsigned Precision, unsigned Scale> std::size_t HashValue(const Decimal<Precision, Scale> value) {
+		const auto units = value.units;
+		const auto high = static_cast<std::uint64_t>(units >> 32 >> 32);
+		return std::hash<std::uint64_t>{}(static_cast<std::uint64_t>(units) ^ (high * 0x9E3779B97F4A7C15));
+	}
+
+	template <typename T> std::size_t HashValue(const std::optional<T>& value) {
+		return value ? HashValue(*value) : std::numeric_limits<std::size_t>::max();
+	}
+
+	// The default hash of indexes and joins, which covers Date and Decimal keys as well as those std::hash supports.
+	struct ValueHash {
+		template <typename T> std::size_t operator()(const T& value) const { return HashValue(value); }
+	};
+
+	// Aggregators for GroupBy. Each but Count reads one column by index and skips its null values.
+	struct Count {
+		template <typename Row> struct State {
+			std::size_t count = 0;
+
+			template <typename RowView> void Add(const RowView&) noexcept { ++count; }
+			void Merge(const State& other) noexcept { count += other.count; }
+			[[nodiscard]] std::size_t Result() const noexcept { return count; }
+		};
+	};
+
+	// Integers are summed in 64 bits and decimals exactly, in integer units widened to the largest supported precision.
+	template <typename T> struct SumTotal {
+		using type = std::conditional_t<std::is_floating_point<T>::value, double, std::conditional_t<std::is_signed<T>::value, std::int64_t, std::uint64_t>>;
+	};
+	template <unsigned Precision, unsigned Scale> struct SumTotal<Decimal<Precision, Scale>> {
+		using type = Decimal<kMaxDecimalPrecision, Scale>;
+	};
+
+	template <std::size_t Column> struct Sum {
+		template <typename Row> struct State {
+			using Value = typename UnwrapOptional<std::tuple_element_t<Column, Row>>::type;
+			static_assert(std::is_arithmetic<Value>::value || IsDecimal<Value>::value, "Only arithmetic or decimal columns can be summed");
+			using Total = typename SumTotal<Value>::type;
+
+			Total total{};
+
+			template <typename RowView> void Add(const RowView& row) {
+				VisitValue(row.template Get<Column>(), [this](const Value value) { Accumulate(total, value); });
+			}
+			void Merge(const State& other) noexcept { Accumulate(total, other.total); }
+			[[nodiscard]] Total Result() const noexcept { return total; }
+
+		private:
+			template <typename T> static void Accumulate(Total& sum, const T value) noexcept {
+				if constexpr (IsDecimal<T>::value) {
+					sum.units += value.units;
+				}
+				else {
+					sum += value;
+				}
+			}
+		};
+	};
+
+	template <std::size_t Column> struct Mean {
+		template <typename Row> struct State {
+			using Value = typename UnwrapOptional<std::tuple_element_t<Column, Row>>::type;
+			static_assert(std::is_arithmetic<Value>::value || IsDecimal<Value>::value, "Only arithmetic or decimal columns can be averaged");
+
+			double total = 0;
+			std::size_t count = 0;
+
+			template <typename RowView> void Add(const RowView& row) {
+				VisitValue(row.template Get<Column>(), [this](const Value value) { total += static_cast<double>(value); ++count; });
+			}
+			void Merge(const State& other) noexcept { total += other.total; count += other.count; }
+
+			// Empty when every value in the group is null.
+			[[nodiscard]] std::optional<double> Result() const noexcept {
+				return count != 0 ? std::optional<double>{total / static_cast<double>(count)} : std::nullopt;
+			}
+		};
+	};
+
+	template <std::size_t Column, typename Compare> struct Extremum {
+		template <typename Row> struct State {
+			using Value = decltype(OwnedValue(std::declval<const typename UnwrapOptional<std::tuple_element_t<Column, Row>>::type&>()));
+
+			std::optional<Value> extremum;
+
+			template <typename RowView> void Add(const RowView& row) {
+				VisitValue(row.template Get<Column>(), [this](const auto& value) {
+					if (!extremum || Compare{}(ValueView(value), *extremum)) {
+						extremum = OwnedValue(value);
+					}
+				});
+			}
+			void Merge(const State& other) {
+				if (other.extremum && (!extremum || Compare{}(*other.extremum, *extremum))) {
+					extremum = other.extremum;
+				}
+			}
+
+			// Empty when every value in the group is null.
+			[[nodiscard]] std::optional<Value> Result() const { return extremum; }
+		};
+	};
+
+	template <std::size_t Column> struct Min : Extremum<Column, std::less<>> {};
+	template <std::size_t Column> struct Max : Extremum<Column, std::greater<>> {};
+
+	template <std::size_t... Columns> struct GroupKey {};
+
+	template <typename Row, typename Key, typename... Aggregates> class GroupBy;
+
+	// Hash aggregation of rows grouped by the values of zero or more key columns. A materialized table is split across
+	// threads which each aggregate into a partial table of their own, and the partial tables are merged at the end. Rows
+	// read while streaming are aggregated one at a time. Groups are reported in the order their keys first appear.
+	template <typename... ColumnTypes, std::size_t... KeyColumns, typename... Aggregates>
+	class GroupBy<std::tuple<ColumnTypes...>, GroupKey<KeyColumns...>, Aggregates...> {
+
+		using Row = std::tuple<ColumnTypes...>;
+		using States = std::tuple<typename Aggregates::template State<Row>...>;
+
+	public:
+		using Key = std::tuple<decltype(OwnedValue(std::declval<const std::tuple_element_t<KeyColumns, Row>&>()))...>;
+		using Values = std::tuple<decltype(std::declval<const typename Aggregates::template State<Row>&>().Result())...>;
+
+		struct Group {
+			Key key;
+			Values values;
+		};
+
+		// Aggregates a row read by a RowReader with the same column types.
+		void Add(const Row& row) { table_.Add(TupleRow{row}); }
+
+		// Aggregates every row of a table.
+		template <typename DialectType> void Add(const BasicCsv<DialectType, ColumnTypes...>& csv) {
+			const auto row_count = csv.RowCount();
+			const auto thread_count = ThreadCount(row_count);
+
+			std::vector<Table> partials(thread_count);
+			RunParallel(thread_count, [&](const std::size_t slice) {
+				const auto first = row_count * slice / thread_count;
+				const auto last = row_count * (slice + 1) / thread_count;
+				for (const auto row : csv.Rows(first, last - first)) {
+					partials[slice].Add(row);
+				}
+			});
+
+			for (const auto& partial : partials) {
+				table_.Merge(partial);
+			}
+		}
+
+		[[nodiscard]] std::vector<Group> Groups() const { return table_.Groups(); }
+		[[nodiscard]] std::size_t GroupCount() const noexcept { return table_.size(); }
+
+	private:
+		struct TupleRow {
+			const Row& row;
+
+			template <std::size_t ColumnIndex> [[nodiscard]] const auto& Get() const noexcept { return std::get<ColumnIndex>(row); }
+		};
+
+		// Keys and aggregate states in an open-addressing hash table. Keys are compared against the row's values in place
+		// and only copied when a new group is inserted.
+		class Table {
+
+			static constexpr std::uint32_t kEmptySlot = std::numeric_limits<std::uint32_t>::max();
+
+		public:
+			template <typename RowView> void Add(const RowView& row) {
+				auto& states = states_[FindOrInsert(
+					HashKey(row),
+					[&](const Key& key) { return KeyEquals(key, row, std::make_index_sequence<sizeof...(KeyColumns)>{}); },
+					[&] { return Key{OwnedValue(row.template Get<KeyColumns>())...}; })];
+				std::apply([&](auto&... state) { (state.Add(row), ...); }, states);
+			}
+
+			void Merge(const Table& other) {
+				for (std::size_t entry = 0; entry < other.size(); ++entry) {
+					const auto& key = other.keys_[entry];
+					auto& states = states_[FindOrInsert(
+						other.hashes_[entry], [&](const Key& candidate) { return candidate == key; }, [&] { return key; })];
+					MergeStates(states, other.states_[entry], std::index_sequence_for<Aggregates...>{});
+				}
+			}
+
+			[[nodiscard]] std::vector<Group> Groups() const {
+				std::vector<Group> groups;
+				groups.reserve(size());
+				for (std::size_t entry = 0; entry < size(); ++entry) {
+					groups.push_back({keys_[entry], std::apply([](const auto&... state) { return Values{state.Result()...}; }, states_[entry])});
+				}
+				return groups;
+			}
+
+			[[nodiscard]] std::size_t size() const noexcept { return keys_.size(); }
+
+		private:
+			template <typename RowView> static std::uint64_t HashKey(const RowView& row) {
+				std::uint64_t hash = 0;
+				((hash = (hash ^ HashValue(ValueView(row.template Get<KeyColumns>()))) * 0x9E3779B97F4A7C15), ...);
+				return hash ^ (hash >> 32);
+			}
+
+			template <typename RowView, std::size_t... Positions>
+			static bool KeyEquals(const Key& key, const RowView& row, std::index_sequence<Positions...>) {
+				return ((std::get<Positions>(key) == ValueView(row.template Get<KeyColumns>())) && ...);
+			}
+
+			template <std::size_t... Positions> static void MergeStates(States& states, const States& other, std::index_sequence<Positions...>) {
+				(std::get<Positions>(states).Merge(std::get<Positions>(other)), ...);
+			}
+
+			template <typename Equals, typename MakeKey>
+			std::size_t FindOrInsert(const std::uint64_t hash, const Equals& equals, const MakeKey& make_key) {
+				if ((size() + 1) * 2 > slots_.size()) {
+					Rehash(std::max<std::size_t>(slots_.size() * 2, 16));
+				}
+
+				auto slot = hash & (slots_.size() - 1);
+				for (; slots_[slot] != kEmptySlot; slot = (slot + 1) & (slots_.size() - 1)) {
+					if (const auto entry = slots_[slot]; hashes_[entry] == hash && equals(keys_[entry])) {
+						return entry;
+					}
+				}
+
+				if (size() >= kEmptySlot) {
+					throw std::runtime_error{"Group count exceeds the maximum"};
+				}
+				const auto entry = static_cast<std::uint32_t>(size());
+				keys_.push_back(make_key());
+				hashes_.push_back(hash);
+				states_.emplace_back();
+				slots_[slot] = entry;
+				return entry;
+			}
+
+			void Rehash(const std::size_t slot_count) {
+				slots_.assign(slot_count, kEmptySlot);
+				for (std::uint32_t entry = 0; entry < size(); ++entry) {
+					auto slot = hashes_[entry] & (slot_count - 1);
+					while (slots_[slot] != kEmptySlot) {
+						slot = (slot + 1) & (slot_count - 1);
+					}
+					slots_[slot] = entry;
+				}
+			}
+
+			std::vector<Key> keys_;
+			std::vector<std::uint64_t> hashes_;
+			std::vector<States> states_;
+			std::vector<std::uint32_t> slots_;
+		};
+
+		Table table_;
+	};
+
+	// Groups the rows of a table by KeyColumns, e.g. Aggregate<GroupKey<0>, Count, Sum<2>>(csv).
+	template <typename KeyColumns, typename... Aggregates, typename DialectType, typename... ColumnTypes>
+	[[nodiscard]] auto Aggregate(const BasicCsv<DialectType, ColumnTypes...>& csv) {
+		GroupBy<std::tuple<ColumnTypes...>, KeyColumns, Aggregates...> group_by;
+		group_by.Add(csv);
+		return group_by.Groups();
+	}
+
+#ifdef CSV_HAS_POSIX_IO
+
+	// A read-only table over a memory-mapped file that holds at most about memory_budget bytes of parsed rows. Records are
+	// parsed in blocks of block_rows on first access, and the least recently used blocks are evicted once the budget is
+	// exceeded, to be parsed again from the mapping when next touched. Not safe for concurrent use.
+	template <typename DialectType, typename... ColumnTypes> class BasicPagedCsv {
+
+		static_assert(sizeof...(ColumnTypes) >= 2, "Paged tables require at least two columns");
+
+		static constexpr std::size_t kNone = std::numeric_limits<std::size_t>::max();
+
+	public:
+		using CsvType = BasicCsv<DialectType, ColumnTypes...>;
+
+		static constexpr std::size_t kDefaultBlockRows = 16384;
+
+		BasicPagedCsv(const std::string& path, const std::size_t memory_budget, const std::size_t block_rows = kDefaultBlockRows,
+			const DialectType& dialect = {})
+			: file_{path}, dialect_{dialect}, memory_budget_{memory_budget}, block_rows_{block_rows} {
+			if (block_rows_ == 0) {
+				throw std::runtime_error{"Block size must be positive"};
+			}
+			IndexBlocks();
+		}
+
+		// Values are returned by copy since the block holding them may be evicted by a later access.
+		template <typename ColumnType>
+		[[nodiscard]] auto Get(const std::size_t row_index, const std::size_t column_index) const
+			-> decltype(OwnedValue(std::declval<typename ColumnTraits<ColumnType>::Reference>())) {
+			if (row_index >= row_count_) {
+				throw std::runtime_error{"Index out of bounds"};
+			}
+			return OwnedValue(LoadBlock(row_index / block_rows_)->template Get<ColumnType>(row_index % block_rows_, column_index));
+		}
+
+		// The rows starting at block_index * BlockRows(), which remain valid for as long as the pointer is held.
+		[[nodiscard]] std::shared_ptr<const CsvType> Block(const std::size_t block_index) const {
+			if (block_index >= BlockCount()) {
+				throw std::runtime_error{"Index out of bounds"};
+			}
+			return LoadBlock(block_index);
+		}
+
+		[[nodiscard]] std::size_t RowCount() const noexcept { return row_count_; }
+		[[nodiscard]] static constexpr std::size_t ColumnCount() noexcept { return sizeof...(ColumnTypes); }
+		[[nodiscard]] std::size_t BlockCount() const noexcept { return blocks_.size(); }
+		[[nodiscard]] std::size_t BlockRows() const noexcept { return block_rows_; }
+
+		[[nodiscard]] std::size_t MemoryBudget() const noexcept { return memory_budget_; }
+		[[nodiscard]] std::size_t CachedBytes() const noexcept { return cached_bytes_; }
+
+		// Block accesses served from the cache and those which had to parse the block.
+		[[nodiscard]] std::size_t Hits() const noexcept { return hits_; }
+		[[nodiscard]] std::size_t Misses() const noexcept { return misses_; }
+
+	private:
+		// Cached blocks form a doubly linked list from most to least recently used.
+		struct Entry {
+			std::shared_ptr<const CsvType> table;
+			std::size_t bytes = 0;
+			std::size_t previous = kNone;
+			std::size_t next = kNone;
+		};
+
+		// Records the byte offset at which each block starts, so a block can be parsed without scanning its predecessors.
+		void IndexBlocks() {
+			const auto data = file_.Data();
+			Tokenizer<DialectType> tokenizer{dialect_};
+			std::size_t position = HasUtf8Bom(data) ? kUtf8Bom.size() : 0;
+			block_offsets_.push_back(position);
+
+			for (std::string_view record; tokenizer.NextRecord(data, position, record, true);) {
+				if (++row_count_ % block_rows_ == 0) {
+					block_offsets_.push_back(position);
+				}
+			}
+			if (row_count_ % block_rows_ != 0) {
+				block_offsets_.push_back(position);
+			}
+			blocks_.resize(block_offsets_.size() - 1);
+		}
+
+		std::shared_ptr<const CsvType> LoadBlock(const std::size_t block_index) const {
+			auto& entry = blocks_[block_index];
+			if (entry.table) {
+				++hits_;
+				Unlink(block_index);
+				PushFront(block_index);
+				return entry.table;
+			}
+
+			++misses_;
+			auto table = std::make_shared<CsvType>(std::string_view{}, dialect_);
+			table->Append(file_.Data().substr(block_offsets_[block_index], block_offsets_[block_index + 1] - block_offsets_[block_index]));
+
+			const auto bytes = table->MemoryUsage();
+			while (tail_ != kNone && cached_bytes_ + bytes > memory_budget_) {
+				Evict(tail_);
+			}
+			entry.table = std::move(table);
+			entry.bytes = bytes;
+			cached_bytes_ += bytes;
+			PushFront(block_index);
+			return entry.table;
+		}
+
+		// Also releases the pages of the mapping that lie wholly within the block, so the source text does not stay
+		// resident either.
+		void Evict(const std::size_t block_index) const {
+			auto& entry = blocks_[block_index];
+			Unlink(block_index);
+			entry.table.reset();
+			cached_bytes_ -= entry.bytes;
+
+			static const auto page_size = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+			const auto data = reinterpret_cast<std::uintptr_t>(file_.Data().data());
+			const auto first = (data + block_offsets_[block_index] + page_size - 1) / page_size * page_size;
+			const auto last = (data + block_offsets_[block_index + 1]) / page_size * page_size;
+			if (first < last) {
+				::madvise(reinterpret_cast<void*>(first), last - first, MADV_DONTNEED);
+			}
+		}
+
+		void PushFront(const std::size_t block_index) const {
+			auto& entry = blocks_[block_index];
+			entry.previous = kNone;
+			entry.next = head_;
+			if (head_ != kNone) {
+				blocks_[head_].previous = block_index;
+			}
+			head_ = block_index;
+			if (tail_ == kNone) {
+				tail_ = block_index;
+			}
+		}
+
+		void Unlink(const std::size_t block_index) const {
+			auto& entry = blocks_[block_index];
+			(entry.previous != kNone ? blocks_[entry.previous].next : head_) = entry.next;
+			(entry.next != kNone ? blocks_[entry.next].previous : tail_) = entry.previous;
+			entry.previous = entry.next = kNone;
+		}
+
+		MappedFile file_;
+		DialectType dialect_;
+		std::size_t memory_budget_;
+		std::size_t block_rows_;
+		std::size_t row_count_ = 0;
+		std::vector<std::size_t> block_offsets_;
+		mutable std::vector<Entry> blocks_;
+		mutable std::size_t head_ = kNone;
+		mutable std::size_t tail_ = kNone;
+		mutable std::size_t cached_bytes_ = 0;
+		mutable std::size_t hits_ = 0;
+		mutable std::size_t misses_ = 0;
+	};
+
+	template <typename... ColumnTypes> using PagedCsv = BasicPagedCsv<CsvDialect, ColumnTypes...>;
+
+#endif
+
+	enum class ColumnType { kBool, kInt32, kInt64, kDouble, kDate, kString };
+
+	struct ColumnSchema {
+		std::string name;
+		ColumnType type = ColumnType::kString;
+		bool nullable = false;
+	};
+
+	struct Schema {
+		RuntimeDialect dialect;
+		bool has_header = false;
+		std::vector<ColumnSchema> columns;
+	};
+
+	struct SniffOptions {
+		std::size_t sample_rows = 1000;
+		std::size_t sample_blocks = 1;  // when greater than one, rows are sampled from evenly spaced blocks across the input
+	};
+
+	class Sniffer final : public CsvBase {
+
+		static constexpr char kCandidateDelimiters[] = {',', '\t', ';', '|'};
+
+	public:
+		static Schema Sniff(const std::string_view data, const SniffOptions& options = {}) {
+			Schema schema;
+			const auto text = HasUtf8Bom(data) ? data.substr(kUtf8Bom.size()) : data;
+			schema.dialect.line_ending = DetectLineEnding(text.substr(0, 1 << 16));
+
+			const auto records = SampleRecords(text, schema.dialect, options);
+			schema.dialect.delimiter = DetectDelimiter(records, schema.dialect);
+
+			Tokenizer<RuntimeDialect> tokenizer{schema.dialect};
+			std::vector<std::vector<std::string>> rows;
+			rows.reserve(records.size());
+			for (const auto& record : records) {
+				const auto& fields = tokenizer.Split(record);
+				rows.emplace_back(fields.begin(), fields.end());
+			}
+
+			std::size_t column_count = 0;
+			for (const auto& row : rows) {
+				column_count = std::max(column_count, row.size());
+			}
+
+			schema.columns.resize(column_count);
+			for (std::size_t column = 0; column < column_count; ++column) {
+				auto& column_schema = schema.columns[column];
+				const auto [type, nullable] = InferColumn(rows, column, 1);
+				column_schema.type = type;
+				column_schema.nullable = nullable;
+			}
+
+			schema.has_header = rows.size() > 1 && DetectHeader(rows, schema.columns);
+			for (std::size_t column = 0; column < column_count; ++column) {
+				auto& column_schema = schema.columns[column];
+				if (schema.has_header) {
+					column_schema.name = column < rows.front().size() ? rows.front()[column] : std::string{};
+				}
+				else {
+					column_schema.name = "column" + std::to_string(column);
+					const auto [type, nullable] = InferColumn(rows, column, 0);
+					column_schema.type = type;
+					column_schema.nullable = nullable;
+				}
+			}
+
+			return schema;
+		}
+
+	private:
+		struct ColumnInference {
+			ColumnType type;
+			bool nullable;
+		};
+
+		static LineEnding DetectLineEnding(const std::string_view data) noexcept {
+			if (data.find("\r\n") != std::string_view::npos) {
+				return LineEnding::kCrLf;
+			}
+			if (data.find('\r') != std::string_view::npos && data.find('\n') == std::string_view::npos) {
+				return LineEnding::kCr;
+			}
+			return LineEnding::kLf;
+		}
+
+		static std::vector<std::string_view> SampleRecords(const std::string_view data, const RuntimeDialect& dialect, const SniffOptions& options) {
+			const auto blocks = std::max<std::size_t>(options.sample_blocks, 1);
+			const auto rows_per_block = std::max<std::size_t>(options.sample_rows / blocks, 1);
+			const Tokenizer<RuntimeDialect> tokenizer{dialect};
+			std::vector<std::string_view> records;
+
+			for (std::size_t block = 0; block < blocks; ++block) {
+				auto position = data.size() / blocks * block;
+				if (block != 0) {
+					// skip the partial record the block starts in
+					position = data.find(dialect.line_ending == LineEnding::kCr ? '\r' : '\n', position);
+					if (position == std::string_view::npos) {
+						break;
+					}
+					++position;
+				}
+
+				std::string_view record;
+				for (std::size_t row = 0; row < rows_per_block && tokenizer.NextRecord(data, position, record, true); ++row) {
+					records.push_back(record);
+				}
+			}
+
+			return records;
+		}
+
+		// Picks the delimiter which most often splits records into the same number of fields greater than one.
+		static char DetectDelimiter(const std::vector<std::string_view>& records, const RuntimeDialect& dialect) {
+			auto best_delimiter = kCandidateDelimiters[0];
+			std::size_t best_score = 0;
+
+			for (const auto delimiter : kCandidateDelimiters) {
+				auto candidate = dialect;
+				candidate.delimiter = delimiter;
+				Tokenizer<RuntimeDialect> tokenizer{candidate};
+
+				std::vector<std::size_t> field_counts;
+				field_counts.reserve(records.size());
+				try {
+					for (const auto& record : records) {
+						field_counts.push_back(tokenizer.Split(record).size());
+					}
+				}
+				catch (const std::runtime_error&) {
+					continue;
+				}
+
+				std::sort(field_counts.begin(), field_counts.end());
+				std::size_t score = 0;
+				for (auto first = field_counts.begin(); first != field_counts.end();) {
+					const auto last = std::upper_bound(first, field_counts.end(), *first);
+					if (*first > 1) {
+						score = std::max(score, static_cast<std::size_t>(last - first));
+					}
+					first = last;
+				}
+
+				if (score > best_score) {
+					best_score = score;
+					best_delimiter = delimiter;
+				}
+			}
+
+			return best_delimiter;
+		}
+
+		static std::optional<ColumnType> FieldType(const std::string_view field) noexcept {
+			if (field.empty()) {
+				return std::nullopt;
+			}
+
+			const auto first = field.data() + ExplicitPlusLength(field);
+			const auto last = field.data() + field.size();
+			const auto parses = [&](auto value) {
+				const auto [end, error] = std::from_chars(first, last, value);
+				return error == std::errc{} && end == last;
+			};
+
+			// 0 and 1 are treated as integers rather than booleans
+			if (ParseBool(field) && !(field.front() >= '0' && field.front() <= '9')) {
+				return ColumnType::kBool;
+			}
+			if (parses(std::int32_t{})) {
+				return ColumnType::kInt32;
+			}
+			if (parses(std::int64_t{})) {
+				return ColumnType::kInt64;
+			}
+			if (ParseDate(field)) {
+				return ColumnType::kDate;
+			}
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+			return parses(double{}) ? ColumnType::kDouble : ColumnType::kString;
+#else
+			try {
+				ParseValue<double>(field);
+				return ColumnType::kDouble;
+			}
+			catch (const std::runtime_error&) {
+				return ColumnType::kString;
+			}
+#endif
+		}
+
+		// Numeric types widen into one another; any other combination of types can only be represented as a string.
+		static ColumnType Join(const ColumnType lhs, const ColumnType rhs) noexcept {
+			const auto numeric = [](const ColumnType type) {
+				return type == ColumnType::kInt32 || type == ColumnType::kInt64 || type == ColumnType::kDouble;
+			};
+			if (lhs == rhs) {
+				return lhs;
+			}
+			if (numeric(lhs) && numeric(rhs)) {
+				return std::max(lhs, rhs);
+			}
+			return ColumnType::kString;
+		}
+
+		static ColumnInference InferColumn(const std::vector<std::vector<std::string>>& rows, const std::size_t column, const std::size_t first_row) {
+			std::optional<ColumnType> type;
+			auto nullable = false;
 
-	protected:
-		CsvBase() = default;
+			for (auto row = first_row; row < rows.size(); ++row) {
+				const auto field_type = column < rows[row].size() ? FieldType(rows[row][column]) : std::nullopt;
+				if (!field_type) {
+					nullable = true;
+				}
+				else {
+					type = type ? Join(*type, *field_type) : *field_type;
+				}
+			}
 
-		static std::vector<std::string_view> Split(const std::string_view data, const char delimiter) {
-			std::vector<std::string_view> tokens;
+			return {type.value_or(ColumnType::kString), nullable};
+		}
 
-			for (std::size_t i = 0, j = 0; j != std::string_view::npos; i = j + 1) {
-				if (j = data.find_first_of(delimiter, i); i != j) {
-					tokens.push_back(data.substr(i, j - i));
+		// The first row is a header when its fields fail to parse as the types inferred for the rows which follow it.
+		// Typed columns vote for a header when the first field does not fit the type of the rest. Only when every column
+		// holds strings do they decide instead, voting for a header when its name repeats no value below it, as names do.
+		static bool DetectHeader(const std::vector<std::vector<std::string>>& rows, const std::vector<ColumnSchema>& columns) {
+			const auto& first_row = rows.front();
+			auto typed_votes = 0;
+			auto string_votes = 0;
+			auto typed_columns = false;
+			for (std::size_t column = 0; column < columns.size() && column < first_row.size(); ++column) {
+				if (columns[column].type == ColumnType::kString) {
+					const auto repeated = first_row[column].empty() || std::any_of(rows.begin() + 1, rows.end(), [&](const auto& row) {
+						return column < row.size() && row[column] == first_row[column];
+					});
+					string_votes += repeated ? -1 : 1;
+					continue;
 				}
+				typed_columns = true;
+				const auto field_type = FieldType(first_row[column]);
+				typed_votes += field_type && Join(*field_type, columns[column].type) == columns[column].type ? -1 : 1;
+			}
+			return (typed_columns ? typed_votes : string_votes) > 0;
+		}
+	};
+
+	// Infers the dialect, header presence and narrowest type of each column from a sample of the input.
+	inline Schema Sniff(const std::string_view data, const SniffOptions& options = {}) {
+		return Sniffer::Sniff(data, options);
+	}
+
+	// Column storage for a runtime schema. The active alternative doubles as the column's type tag and follows the order of
+	// ColumnType, so checking a requested type is a single index comparison.
+	using DynamicColumn = std::variant<NullableColumn<bool>, NullableColumn<std::int32_t>, NullableColumn<std::int64_t>,
+		NullableColumn<double>, NullableColumn<Date>, NullableColumn<std::string>>;
+
+	// A table whose column types are chosen at runtime, e.g. from a configuration file or by Sniff.
+	class DynamicCsv final : public CsvBase {
+
+	public:
+		class Row {
+
+		public:
+			Row(const DynamicCsv* const csv, const std::size_t index) noexcept : csv_{csv}, index_{index} {}
+
+			template <typename T>
+			[[nodiscard]] typename ColumnTraits<std::optional<T>>::Reference Get(const std::size_t column_index) const {
+				return csv_->Column<T>(column_index)[index_];
 			}
 
-			return tokens;
+			[[nodiscard]] std::size_t Index() const noexcept { return index_; }
+
+		private:
+			const DynamicCsv* csv_;
+			std::size_t index_;
+		};
+
+		using RowType = Row;
+		using Iterator = RowIterator<DynamicCsv>;
+
+		DynamicCsv(const std::string_view data, csv::Schema schema) : schema_{std::move(schema)} {
+			RecordReader<RuntimeDialect> records{data, schema_.dialect};
+			ParseRecords(records);
 		}
 
-		template <typename T> static T ParseToken(const std::string_view token) {
-			T element;
-			if constexpr (std::is_same<T, bool>::value) {
-				std::istringstream{token.data()} >> std::boolalpha >> element;
+		DynamicCsv(InputSource& source, csv::Schema schema) : schema_{std::move(schema)} {
+			RecordReader<RuntimeDialect> records{source, RecordReader<RuntimeDialect>::kDefaultBufferSize, schema_.dialect};
+			ParseRecords(records);
+		}
+
+		template <typename T>
+		[[nodiscard]] typename ColumnTraits<std::optional<T>>::Reference Get(const std::size_t row_index, const std::size_t column_index) const {
+			const auto& column = Column<T>(column_index);
+			if (row_index >= column.size()) {
+				throw std::runtime_error{"Index out of bounds"};
 			}
-			else {
-				std::istringstream{token.data()} >> element;
+			return column[row_index];
+		}
+
+		// Throws when T does not match the column type in the schema.
+		template <typename T> [[nodiscard]] const NullableColumn<T>& Column(const std::size_t column_index) const {
+			if (column_index >= columns_.size()) {
+				throw std::runtime_error{"Index out of bounds"};
+			}
+			if (const auto* const column = std::get_if<NullableColumn<T>>(&columns_[column_index])) {
+				return *column;
+			}
+			throw std::runtime_error{"Column type mismatch"};
+		}
+
+		// Invokes visitor with the column's NullableColumn of its schema type.
+		template <typename Visitor> decltype(auto) VisitColumn(const std::size_t column_index, Visitor&& visitor) const {
+			CheckRange(column_index, 1, ColumnCount());
+			return std::visit(std::forward<Visitor>(visitor), columns_[column_index]);
+		}
+
+		[[nodiscard]] std::size_t ColumnIndex(const std::string_view name) const {
+			for (std::size_t column_index = 0; column_index < schema_.columns.size(); ++column_index) {
+				if (schema_.columns[column_index].name == name) {
+					return column_index;
+				}
+			}
+			throw std::runtime_error{"Unknown column: " + std::string{name}};
+		}
+
+		[[nodiscard]] Row operator[](const std::size_t row_index) const {
+			CheckRange(row_index, 1, RowCount());
+			return RowAt(row_index);
+		}
+
+		[[nodiscard]] RowRange<Iterator> Rows(const std::size_t first, const std::size_t count) const {
+			CheckRange(first, count, RowCount());
+			return {Iterator{this, first}, Iterator{this, first + count}};
+		}
+
+		[[nodiscard]] Iterator begin() const noexcept { return {this, 0}; }
+		[[nodiscard]] Iterator end() const noexcept { return {this, RowCount()}; }
+
+		// A stable permutation of the rows ordered by the given columns, the first of which is the most significant.
+		[[nodiscard]] std::vector<std::size_t> SortedOrder(const std::vector<std::size_t>& sort_columns) const {
+			std::vector<std::size_t> order(RowCount());
+			std::iota(order.begin(), order.end(), std::size_t{0});
+			for (auto column_index = sort_columns.rbegin(); column_index != sort_columns.rend(); ++column_index) {
+				CheckRange(*column_index, 1, ColumnCount());
+				std::visit([&](const auto& column) { SortRowsByColumn(order, column); }, columns_[*column_index]);
+			}
+			return order;
+		}
+
+		// Reorders the rows of every column by the given columns, as SortedOrder does.
+		void Sort(const std::vector<std::size_t>& sort_columns) {
+			const auto order = SortedOrder(sort_columns);
+			for (auto& column : columns_) {
+				std::visit([&](auto& values) { values = PermuteColumn(values, order); }, column);
+			}
+		}
+
+		[[nodiscard]] const csv::Schema& GetSchema() const noexcept { return schema_; }
+		[[nodiscard]] std::size_t RowCount() const noexcept { return row_count_; }
+		[[nodiscard]] std::size_t ColumnCount() const noexcept { return columns_.size(); }
+
+	private:
+		friend class RowIterator<DynamicCsv>;
+
+		[[nodiscard]] Row RowAt(const std::size_t row_index) const noexcept { return {this, row_index}; }
+
+		void ParseRecords(RecordReader<RuntimeDialect>& records) {
+			columns_.reserve(schema_.columns.size());
+			for (const auto& column_schema : schema_.columns) {
+				columns_.push_back(MakeColumn(column_schema.type));
+			}
+
+			Tokenizer<RuntimeDialect> tokenizer{schema_.dialect};
+			std::string_view record;
+			if (schema_.has_header) {
+				records.Next(record);
+			}
+
+			for (; records.Next(record); ++row_count_) {
+				const auto& fields = tokenizer.Split(record);
+				for (std::size_t column_index = 0; column_index < columns_.size(); ++column_index) {
+					const auto field = FieldAt(fields, column_index);
+					const auto nullable = schema_.columns[column_index].nullable;
+					std::visit(
+						[&](auto& column) {
+							using T = typename std::decay_t<decltype(column)>::ElementType;
+							column.push_back(nullable ? ParseToken<std::optional<T>>(field) : ParseToken<T>(field));
+						},
+						columns_[column_index]);
+				}
+			}
+		}
+
+		static DynamicColumn MakeColumn(const ColumnType type) {
+			switch (type) {
+				case ColumnType::kBool: return NullableColumn<bool>{};
+				case ColumnType::kInt32: return NullableColumn<std::int32_t>{};
+				case ColumnType::kInt64: return NullableColumn<std::int64_t>{};
+				case ColumnType::kDouble: return NullableColumn<double>{};
+				case ColumnType::kDate: return NullableColumn<Date>{};
+				case ColumnType::kString: return NullableColumn<std::string>{};
+			}
+			throw std::runtime_error{"Invalid column type"};
+		}
+
+		csv::Schema schema_;
+		std::vector<DynamicColumn> columns_;
+		std::size_t row_count_ = 0;
+	};
+
+	// Reads index keys out of column views. The null rows of a NullableColumn have no key.
+	struct ColumnKeys {
+		template <typename Keys> static bool IsValid(const Keys&, const std::size_t) noexcept { return true; }
+		template <typename T> static bool IsValid(const NullableColumn<T>& keys, const std::size_t row) noexcept { return keys.IsValid(row); }
+
+		template <typename Keys> static decltype(auto) ValueAt(const Keys& keys, const std::size_t row) { return keys[row]; }
+		template <typename T> static decltype(auto) ValueAt(const NullableColumn<T>& keys, const std::size_t row) { return keys.Values()[row]; }
+	};
+
+	// Maps each distinct key of a column to the rows which hold it. Keys are copied into a flat open-addressing table and
+	// the rows of each key are grouped in one contiguous array, so lookups never touch the table or its other columns.
+	// Columns of std::string can be indexed by std::string_view keys which refer into the table's storage.
+	template <typename Key, typename Hash = ValueHash> class HashIndex {
+
+		static constexpr std::uint32_t kEmptySlot = std::numeric_limits<std::uint32_t>::max();
+
+	public:
+		// Keys may be any column view, including a NullableColumn whose null rows are left out of the index. When unique
+		// is set, a repeated key throws.
+		template <typename Keys> explicit HashIndex(const Keys& keys, const bool unique = false) {
+			std::vector<std::uint32_t> row_entries(keys.size(), kEmptySlot);
+			for (std::size_t row = 0; row < keys.size(); ++row) {
+				if (ColumnKeys::IsValid(keys, row)) {
+					row_entries[row] = Insert(Key(ColumnKeys::ValueAt(keys, row)), unique);
+				}
+			}
+
+			for (std::size_t entry = 1; entry < offsets_.size(); ++entry) {
+				offsets_[entry] += offsets_[entry - 1];
+			}
+			rows_.resize(offsets_.back());
+
+			auto cursors = offsets_;
+			for (std::size_t row = 0; row < row_entries.size(); ++row) {
+				if (row_entries[row] != kEmptySlot) {
+					rows_[cursors[row_entries[row]]++] = row;
+				}
+			}
+		}
+
+		// The first row holding key.
+		[[nodiscard]] std::optional<std::size_t> Find(const Key& key) const {
+			if (const auto entry = FindEntry(key)) {
+				return rows_[offsets_[*entry]];
+			}
+			return std::nullopt;
+		}
+
+		// Every row holding key in ascending order.
+		[[nodiscard]] Span<const std::size_t> EqualRange(const Key& key) const {
+			if (const auto entry = FindEntry(key)) {
+				return {rows_.data() + offsets_[*entry], offsets_[*entry + 1] - offsets_[*entry]};
+			}
+			return {};
+		}
+
+		[[nodiscard]] bool Contains(const Key& key) const { return FindEntry(key).has_value(); }
+		[[nodiscard]] std::size_t DistinctCount() const noexcept { return keys_.size(); }
+
+	private:
+		// Spreads keys such as sequential or strided integers, which hashes often map to themselves, across all slots.
+		static std::uint64_t HashOf(const Key& key) {
+			const auto hash = static_cast<std::uint64_t>(Hash{}(key)) * 0x9E3779B97F4A7C15;
+			return hash ^ (hash >> 32);
+		}
+
+		std::optional<std::uint32_t> FindEntry(const Key& key) const {
+			if (slots_.empty()) {
+				return std::nullopt;
+			}
+			const auto hash = HashOf(key);
+			for (auto slot = hash & (slots_.size() - 1);; slot = (slot + 1) & (slots_.size() - 1)) {
+				if (const auto entry = slots_[slot]; entry == kEmptySlot) {
+					return std::nullopt;
+				}
+				else if (hashes_[entry] == hash && keys_[entry] == key) {
+					return entry;
+				}
+			}
+		}
+
+		// Returns the entry for key after counting one more row for it. offsets_ holds per-entry counts until construction
+		// turns them into prefix sums.
+		std::uint32_t Insert(Key key, const bool unique) {
+			if ((DistinctCount() + 1) * 2 > slots_.size()) {
+				Rehash(std::max<std::size_t>(slots_.size() * 2, 16));
+			}
+
+			const auto hash = HashOf(key);
+			auto slot = hash & (slots_.size() - 1);
+			for (; slots_[slot] != kEmptySlot; slot = (slot + 1) & (slots_.size() - 1)) {
+				if (const auto entry = slots_[slot]; hashes_[entry] == hash && keys_[entry] == key) {
+					if (unique) {
+						throw std::runtime_error{"Duplicate key"};
+					}
+					++offsets_[entry + 1];
+					return entry;
+				}
+			}
+
+			if (DistinctCount() >= kEmptySlot) {
+				throw std::runtime_error{"Index exceeds the maximum number of keys"};
+			}
+			const auto entry = static_cast<std::uint32_t>(DistinctCount());
+			keys_.push_back(std::move(key));
+			hashes_.push_back(hash);
+			offsets_.push_back(1);
+			slots_[slot] = entry;
+			return entry;
+		}
+
+		void Rehash(const std::size_t slot_count) {
+			slots_.assign(slot_count, kEmptySlot);
+			for (std::uint32_t entry = 0; entry < DistinctCount(); ++entry) {
+				auto slot = hashes_[entry] & (slot_count - 1);
+				while (slots_[slot] != kEmptySlot) {
+					slot = (slot + 1) & (slot_count - 1);
+				}
+				slots_[slot] = entry;
+			}
+		}
+
+		std::vector<Key> keys_;
+		std::vector<std::uint64_t> hashes_;
+		std::vector<std::size_t> offsets_{0};
+		std::vector<std::size_t> rows_;
+		std::vector<std::uint32_t> slots_;
+	};
+
+	// Orders the rows of a column by key for range queries. Sorted keys are copied next to their rows, so a binary search
+	// reads only the index. Indexes of trivially copyable keys can be saved alongside the source file and loaded later.
+	template <typename Key> class SortedIndex {
+
+		static constexpr char kMagic[8] = {'C', 'S', 'V', 'S', 'I', 'D', 'X', '3'};
+
+	public:
+		// Keys may be any column view, including a NullableColumn whose null rows are left out of the index.
+		template <typename Keys> explicit SortedIndex(const Keys& keys) : source_rows_{keys.size()} {
+			for (std::size_t row = 0; row < keys.size(); ++row) {
+				if (ColumnKeys::IsValid(keys, row)) {
+					rows_.push_back(row);
+				}
+			}
+			StableSortRows(rows_, [&](const std::size_t row) -> decltype(auto) { return ColumnKeys::ValueAt(keys, row); });
+
+			keys_.reserve(rows_.size());
+			for (const auto row : rows_) {
+				keys_.emplace_back(ColumnKeys::ValueAt(keys, row));
+			}
+		}
+
+		// Loads an index saved from the column keys. The file records the column's row count and a fingerprint of its keys,
+		// so an index saved before the column changed is stale and throws, as does a corrupt file. Checking the fingerprint
+		// hashes each key once, which is much cheaper than sorting them again.
+		template <typename Keys> static SortedIndex Load(std::istream& stream, const Keys& keys) {
+			static_assert(std::is_trivially_copyable<Key>::value, "Only indexes of trivially copyable keys can be loaded");
+
+			char magic[sizeof kMagic] = {};
+			std::uint64_t key_size = 0, source_rows = 0, fingerprint = 0, size = 0;
+			stream.read(magic, sizeof magic);
+			stream.read(reinterpret_cast<char*>(&key_size), sizeof key_size);
+			stream.read(reinterpret_cast<char*>(&source_rows), sizeof source_rows);
+			stream.read(reinterpret_cast<char*>(&fingerprint), sizeof fingerprint);
+			stream.read(reinterpret_cast<char*>(&size), sizeof size);
+			if (!stream || !std::equal(std::begin(magic), std::end(magic), std::begin(kMagic)) || key_size != sizeof(Key) || size > source_rows) {
+				throw std::runtime_error{"Invalid index file"};
+			}
+			if (source_rows != keys.size() || fingerprint != ColumnFingerprint(keys)) {
+				throw std::runtime_error{"Stale index file"};
+			}
+
+			SortedIndex index;
+			index.source_rows_ = keys.size();
+			std::vector<std::uint64_t> rows;
+			ReadValues(stream, index.keys_, size);
+			ReadValues(stream, rows, size);
+			if (std::any_of(rows.begin(), rows.end(), [&](const std::uint64_t row) { return row >= source_rows; })) {
+				throw std::runtime_error{"Invalid index file"};
+			}
+			index.rows_.assign(rows.begin(), rows.end());
+			if (index.Fingerprint() != fingerprint) {
+				throw std::runtime_error{"Invalid index file"};
+			}
+			return index;
+		}
+
+		template <typename Keys> static SortedIndex Load(const std::string& path, const Keys& keys) {
+			std::ifstream stream{path, std::ios::binary};
+			if (!stream) {
+				throw std::runtime_error{"Unable to open " + path};
+			}
+			return Load(stream, keys);
+		}
+
+		void Save(std::ostream& stream) const {
+			static_assert(std::is_trivially_copyable<Key>::value, "Only indexes of trivially copyable keys can be saved");
+
+			const std::uint64_t key_size = sizeof(Key), source_rows = source_rows_, fingerprint = Fingerprint(), size = keys_.size();
+			const std::vector<std::uint64_t> rows(rows_.begin(), rows_.end());
+			stream.write(kMagic, sizeof kMagic);
+			stream.write(reinterpret_cast<const char*>(&key_size), sizeof key_size);
+			stream.write(reinterpret_cast<const char*>(&source_rows), sizeof source_rows);
+			stream.write(reinterpret_cast<const char*>(&fingerprint), sizeof fingerprint);
+			stream.write(reinterpret_cast<const char*>(&size), sizeof size);
+			stream.write(reinterpret_cast<const char*>(keys_.data()), static_cast<std::streamsize>(size * sizeof(Key)));
+			stream.write(reinterpret_cast<const char*>(rows.data()), static_cast<std::streamsize>(size * sizeof(std::uint64_t)));
+			if (!stream) {
+				throw std::runtime_error{"Unable to write index"};
+			}
+		}
+
+		void Save(const std::string& path) const {
+			std::ofstream stream{path, std::ios::binary};
+			if (!stream) {
+				throw std::runtime_error{"Unable to open " + path};
+			}
+			Save(stream);
+		}
+
+		// Positions in key order, for use with Rows(first, last).
+		[[nodiscard]] std::size_t LowerBound(const Key& key) const {
+			return static_cast<std::size_t>(std::lower_bound(keys_.begin(), keys_.end(), key) - keys_.begin());
+		}
+
+		[[nodiscard]] std::size_t UpperBound(const Key& key) const {
+			return static_cast<std::size_t>(std::upper_bound(keys_.begin(), keys_.end(), key) - keys_.begin());
+		}
+
+		// The rows at positions [first, last) in key order.
+		[[nodiscard]] Span<const std::size_t> Rows(const std::size_t first, const std::size_t last) const {
+			if (first > last || last > rows_.size()) {
+				throw std::runtime_error{"Index out of bounds"};
+			}
+			return {rows_.data() + first, last - first};
+		}
+
+		// Rows whose keys lie in [lower, upper), ordered by key and then by row.
+		[[nodiscard]] Span<const std::size_t> Range(const Key& lower, const Key& upper) const {
+			const auto first = LowerBound(lower);
+			return Rows(first, std::max(first, LowerBound(upper)));
+		}
+
+		[[nodiscard]] Span<const std::size_t> EqualRange(const Key& key) const { return Rows(LowerBound(key), UpperBound(key)); }
+
+		[[nodiscard]] Span<const Key> SortedKeys() const noexcept { return {keys_.data(), keys_.size()}; }
+		[[nodiscard]] Span<const std::size_t> Rows() const noexcept { return {rows_.data(), rows_.size()}; }
+		[[nodiscard]] std::size_t size() const noexcept { return rows_.size(); }
+		// The number of rows in the indexed column, including null rows which are not indexed.
+		[[nodiscard]] std::size_t SourceRowCount() const noexcept { return source_rows_; }
+
+	private:
+		SortedIndex() = default;
+
+		// Fingerprints are sums of one mixed hash per (row, key) pair, so the sorted index and the column in row order
+		// produce the same value.
+		static std::uint64_t EntryFingerprint(const std::size_t row, const Key& key) {
+			auto value = static_cast<std::uint64_t>(HashValue(key)) ^ (static_cast<std::uint64_t>(row) * 0x9E3779B97F4A7C15);
+			value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9;
+			value = (value ^ (value >> 27)) * 0x94D049BB133111EB;
+			return value ^ (value >> 31);
+		}
+
+		[[nodiscard]] std::uint64_t Fingerprint() const {
+			std::uint64_t fingerprint = 0;
+			for (std::size_t i = 0; i < rows_.size(); ++i) {
+				fingerprint += EntryFingerprint(rows_[i], keys_[i]);
+			}
+			return fingerprint;
+		}
+
+		template <typename Keys> static std::uint64_t ColumnFingerprint(const Keys& keys) {
+			std::uint64_t fingerprint = 0;
+			for (std::size_t row = 0; row < keys.size(); ++row) {
+				if (ColumnKeys::IsValid(keys, row)) {
+					fingerprint += EntryFingerprint(row, Key(ColumnKeys::ValueAt(keys, row)));
+				}
+			}
+			return fingerprint;
+		}
+
+		// Reads count values in bounded chunks, so a corrupt count fails at the end of the stream rather than allocating for it.
+		template <typename T> static void ReadValues(std::istream& stream, std::vector<T>& values, const std::uint64_t count) {
+			constexpr std::uint64_t kChunkSize = 1 << 16;
+			for (std::uint64_t read = 0; read < count;) {
+				const auto chunk = std::min(kChunkSize, count - read);
+				values.resize(static_cast<std::size_t>(read + chunk));
+				stream.read(reinterpret_cast<char*>(values.data() + read), static_cast<std::streamsize>(chunk * sizeof(T)));
+				if (!stream) {
+					throw std::runtime_error{"Invalid index file"};
+				}
+				read += chunk;
 			}
-			return element;
 		}
+
+		std::size_t source_rows_ = 0;
+		std::vector<Key> keys_;
+		std::vector<std::size_t> rows_;
 	};
 
-	template <typename... ColumnTypes> class Csv final : public CsvBase {
+	enum class JoinType { kInner, kLeft };
 
-		template <typename...> struct TypeList {};
+	// Matching rows of two tables as pairs (left_rows[i], right_rows[i]), ordered by left row and then by right row.
+	struct JoinedRows {
+		// Pairs a left row with no match in a left join.
+		static constexpr std::size_t kNoMatch = std::numeric_limits<std::size_t>::max();
 
-		template <typename TupleType, typename TupleElementType, std::int32_t CurrentIndex = std::tuple_size<TupleType>::value - 1>
-		struct TupleElementAtIndex {
-			static const TupleElementType& Get(const TupleType& tuple, const std::size_t index) {
-				if (index == CurrentIndex) {
-					using ActualTupleElementType = typename std::tuple_element<CurrentIndex, TupleType>::type;
-					if constexpr (std::is_same<TupleElementType, ActualTupleElementType>::value) {
-						return std::get<CurrentIndex>(tuple);
+		std::vector<std::size_t> left_rows;
+		std::vector<std::size_t> right_rows;
+	};
+
+	// Equi-joins two tables on a key column of each. A HashIndex is built on the key column of the smaller table and the
+	// other table is probed in parallel slices. Null keys match nothing.
+	template <std::size_t LeftColumn, std::size_t RightColumn, typename LeftTable, typename RightTable>
+	JoinedRows HashJoin(const LeftTable& left, const RightTable& right, const JoinType type = JoinType::kInner) {
+		const auto& left_keys = left.template Column<LeftColumn>();
+		const auto& right_keys = right.template Column<RightColumn>();
+		using Key = std::decay_t<decltype(ColumnKeys::ValueAt(left_keys, 0))>;
+		static_assert(std::is_same<Key, std::decay_t<decltype(ColumnKeys::ValueAt(right_keys, 0))>>::value, "Key columns must have the same type");
+
+		// Probes each row of one table and returns the matching pairs in probe order.
+		const auto probe = [](const HashIndex<Key>& index, const auto& keys, const bool keep_unmatched) {
+			const auto thread_count = ThreadCount(keys.size());
+			std::vector<JoinedRows> slices(thread_count);
+			RunParallel(thread_count, [&](const std::size_t slice) {
+				auto& [build_rows, probe_rows] = slices[slice];
+				for (auto row = keys.size() * slice / thread_count; row < keys.size() * (slice + 1) / thread_count; ++row) {
+					const auto matches = ColumnKeys::IsValid(keys, row) ? index.EqualRange(Key(ColumnKeys::ValueAt(keys, row))) : Span<const std::size_t>{};
+					build_rows.insert(build_rows.end(), matches.begin(), matches.end());
+					probe_rows.insert(probe_rows.end(), matches.size(), row);
+					if (matches.empty() && keep_unmatched) {
+						build_rows.push_back(JoinedRows::kNoMatch);
+						probe_rows.push_back(row);
 					}
-					else {
-						throw std::runtime_error{"Tuple element type mismatch"};
+				}
+			});
+
+			JoinedRows pairs;
+			for (auto& [build_rows, probe_rows] : slices) {
+				pairs.left_rows.insert(pairs.left_rows.end(), build_rows.begin(), build_rows.end());
+				pairs.right_rows.insert(pairs.right_rows.end(), probe_rows.begin(), probe_rows.end());
+			}
+			return pairs;
+		};
+
+		if (right_keys.size() <= left_keys.size()) {
+			auto pairs = probe(HashIndex<Key>{right_keys}, left_keys, type == JoinType::kLeft);
+			std::swap(pairs.left_rows, pairs.right_rows);
+			return pairs;
+		}
+
+		auto pairs = probe(HashIndex<Key>{left_keys}, right_keys, false);
+		if (type == JoinType::kLeft) {
+			std::vector<bool> matched(left_keys.size());
+			for (const auto row : pairs.left_rows) {
+				matched[row] = true;
+			}
+			for (std::size_t row = 0; row < matched.size(); ++row) {
+				if (!matched[row]) {
+					pairs.left_rows.push_back(row);
+					pairs.right_rows.push_back(JoinedRows::kNoMatch);
+				}
+			}
+		}
+
+		// pairs are in right row order and each left row's matches are already in ascending order
+		std::vector<std::size_t> order(pairs.left_rows.size());
+		std::iota(order.begin(), order.end(), std::size_t{0});
+		StableSortRows(order, [&](const std::size_t pair) { return pairs.left_rows[pair]; });
+
+		JoinedRows sorted;
+		sorted.left_rows.reserve(order.size());
+		sorted.right_rows.reserve(order.size());
+		for (const auto pair : order) {
+			sorted.left_rows.push_back(pairs.left_rows[pair]);
+			sorted.right_rows.push_back(pairs.right_rows[pair]);
+		}
+		return sorted;
+	}
+
+	// Gathers the given columns of a table at rows, e.g. one side of a JoinedRows. Rows equal to JoinedRows::kNoMatch are
+	// null, as are null values. Columns which are not named are never read.
+	template <std::size_t... Columns, typename DialectType, typename... ColumnTypes>
+	[[nodiscard]] auto Project(const BasicCsv<DialectType, ColumnTypes...>& csv, const std::vector<std::size_t>& rows) {
+		std::tuple<NullableColumn<typename UnwrapOptional<std::tuple_element_t<Columns, std::tuple<ColumnTypes...>>>::type>...> projection;
+
+		const auto gather = [&rows](auto& projected, const auto& values) {
+			using T = typename std::decay_t<decltype(projected)>::ElementType;
+			projected.reserve(rows.size());
+			for (const auto row : rows) {
+				if (row == JoinedRows::kNoMatch || !ColumnKeys::IsValid(values, row)) {
+					projected.push_back(std::nullopt);
+				}
+				else {
+					projected.push_back(T{ColumnKeys::ValueAt(values, row)});
+				}
+			}
+		};
+		std::apply([&](auto&... projected) { (gather(projected, csv.template Column<Columns>()), ...); }, projection);
+		return projection;
+	}
+
+	// Exports tables through the Arrow C data interface as a struct array with one child per column. Exported buffers point
+	// into the table's columns rather than at copies of them, so an export costs O(columns). The table must outlive the
+	// exported structures and stay unmodified until they are released.
+	class ArrowExporter {
+
+		struct SchemaData {
+			std::string format;
+			std::string name;
+			std::vector<ArrowSchema> children;
+			std::vector<ArrowSchema*> child_pointers;
+			std::unique_ptr<ArrowSchema> dictionary;
+
+			~SchemaData() {
+				for (auto& child : children) {
+					if (child.release != nullptr) {
+						child.release(&child);
 					}
 				}
-				return TupleElementAtIndex<TupleType, TupleElementType, CurrentIndex - 1>::Get(tuple, index);
+				if (dictionary && dictionary->release != nullptr) {
+					dictionary->release(dictionary.get());
+				}
 			}
 		};
 
-		template <typename TupleType, typename TupleElementType>
-		struct TupleElementAtIndex<TupleType, TupleElementType, static_cast<std::int32_t>(-1)> {
-			static const TupleElementType& Get(const TupleType&, const std::size_t) {
-				throw std::runtime_error{"Index out of bounds"};
+		struct ArrayData {
+			std::vector<const void*> buffers;
+			std::vector<ArrowArray> children;
+			std::vector<ArrowArray*> child_pointers;
+			std::unique_ptr<ArrowArray> dictionary;
+
+			~ArrayData() {
+				for (auto& child : children) {
+					if (child.release != nullptr) {
+						child.release(&child);
+					}
+				}
+				if (dictionary && dictionary->release != nullptr) {
+					dictionary->release(dictionary.get());
+				}
 			}
 		};
 
 	public:
-		explicit Csv(const std::string_view data) : elements_{ParseData(data)} {}
+		// Children are named after names, or left unnamed where names runs out.
+		template <typename DialectType, typename... ColumnTypes>
+		static void Export(
+			const BasicCsv<DialectType, ColumnTypes...>& csv, const std::vector<std::string>& names, ArrowArray* const array, ArrowSchema* const schema) {
 
-		template <typename ColumnType>
-		[[nodiscard]] const ColumnType& Get(const std::size_t row_index, const std::size_t column_index) const {
-			if (row_index >= elements_.size()) {
-				throw std::runtime_error{"Index out of bounds"};
-			}
-			return TupleElementAtIndex<std::tuple<ColumnTypes...>, ColumnType>::Get(elements_[row_index], column_index);
+			Export(csv.RowCount(), sizeof...(ColumnTypes), array, schema, [&](ArrowArray* const arrays, ArrowSchema* const schemas) {
+				ExportColumns(csv, names, arrays, schemas, std::index_sequence_for<ColumnTypes...>{});
+			});
+		}
+
+		static void Export(const DynamicCsv& csv, ArrowArray* const array, ArrowSchema* const schema) {
+			Export(csv.RowCount(), csv.ColumnCount(), array, schema, [&](ArrowArray* const arrays, ArrowSchema* const schemas) {
+				for (std::size_t column_index = 0; column_index < csv.ColumnCount(); ++column_index) {
+					csv.VisitColumn(column_index, [&](const auto& column) {
+						ExportColumn(column, csv.GetSchema().columns[column_index].name, arrays[column_index], schemas[column_index]);
+					});
+				}
+			});
 		}
 
 	private:
-		static std::vector<std::tuple<ColumnTypes...>> ParseData(const std::string_view data) {
-			const auto lines = Split(data, '\n');
-			std::vector<std::tuple<ColumnTypes...>> elements;
-			elements.reserve(lines.size());
+		template <typename ExportChildren>
+		static void Export(const std::size_t row_count, const std::size_t column_count, ArrowArray* const array, ArrowSchema* const schema,
+			const ExportChildren& export_children) {
+
+			auto array_data = std::make_unique<ArrayData>();
+			auto schema_data = std::make_unique<SchemaData>();
+			array_data->children.resize(column_count, ArrowArray{});
+			schema_data->children.resize(column_count, ArrowSchema{});
+			export_children(array_data->children.data(), schema_data->children.data());
+
+			Initialize(std::move(array_data), std::move(schema_data), "+s", "", row_count, {nullptr}, *array, *schema);
+		}
 
-			std::transform(std::cbegin(lines), std::cend(lines), std::back_inserter(elements),
-				[](const auto& line) { return ParseLine(line); });
+		template <typename Csv, std::size_t... ColumnIndices>
+		static void ExportColumns(const Csv& csv, const std::vector<std::string>& names, ArrowArray* const arrays, ArrowSchema* const schemas,
+			std::index_sequence<ColumnIndices...>) {
 
-			return elements;
+			(ExportColumn(csv.template Column<ColumnIndices>(), ColumnIndices < names.size() ? names[ColumnIndices] : std::string{},
+				arrays[ColumnIndices], schemas[ColumnIndices]), ...);
 		}
 
-		static std::tuple<ColumnTypes...> ParseLine(const std::string_view line) {
-			const auto tokens = Split(line, ',');
-			return ParseTokens(TypeList<ColumnTypes...>{}, tokens, 0);
+		template <typename T>
+		static void ExportColumn(const Span<const T> values, const std::string& name, ArrowArray& array, ArrowSchema& schema) {
+			Initialize(std::make_unique<ArrayData>(), std::make_unique<SchemaData>(), Format<T>(), name, values.size(), {nullptr, values.data()}, array, schema);
 		}
 
-		template <typename ColumnType, typename... Rest>
-		static std::tuple<ColumnType, Rest...> ParseTokens(
-			const TypeList<ColumnType, Rest...>&, const std::vector<std::string_view>& tokens, const std::size_t index) {
+		static void ExportColumn(const BitVector& values, const std::string& name, ArrowArray& array, ArrowSchema& schema) {
+			Initialize(std::make_unique<ArrayData>(), std::make_unique<SchemaData>(), "b", name, values.size(), {nullptr, values.Words().data()}, array, schema);
+		}
 
-			return std::tuple_cat(
-				std::make_tuple(ParseToken<ColumnType>(tokens[index])),
-				ParseTokens(TypeList<Rest...>{}, tokens, index + 1));
+		static void ExportColumn(const StringColumn& values, const std::string& name, ArrowArray& array, ArrowSchema& schema) {
+			Initialize(std::make_unique<ArrayData>(), std::make_unique<SchemaData>(), "U", name, values.size(),
+				{nullptr, values.ValueOffsets().data(), values.ValueBytes().data()}, array, schema);
 		}
 
-		static std::tuple<> ParseTokens(const TypeList<>&, const std::vector<std::string_view>&, const std::size_t) {
-			return {};
+		// Codes are exported as unsigned indices of their current width into a dictionary of distinct strings.
+		static void ExportColumn(const DictionaryColumn& values, const std::string& name, ArrowArray& array, ArrowSchema& schema) {
+			auto array_data = std::make_unique<ArrayData>();
+			auto schema_data = std::make_unique<SchemaData>();
+			array_data->dictionary = std::make_unique<ArrowArray>();
+			schema_data->dictionary = std::make_unique<ArrowSchema>();
+			Initialize(std::make_unique<ArrayData>(), std::make_unique<SchemaData>(), "u", "", values.DistinctCount(),
+				{nullptr, values.ValueOffsets().data(), values.ValueBytes().data()}, *array_data->dictionary, *schema_data->dictionary);
+
+			const void* const codes = values.VisitCodes([](const auto codes) -> const void* { return codes.data(); });
+			constexpr const char* kCodeFormats[] = {"C", "S", "", "I"};
+			Initialize(std::move(array_data), std::move(schema_data), kCodeFormats[values.CodeWidth() - 1], name, values.size(), {nullptr, codes}, array, schema);
+		}
+
+		template <typename T>
+		static void ExportColumn(const NullableColumn<T>& values, const std::string& name, ArrowArray& array, ArrowSchema& schema) {
+			ExportColumn(values.Values(), name, array, schema);
+			schema.flags |= ARROW_FLAG_NULLABLE;
+			if (values.NullCount() != 0) {
+				array.null_count = static_cast<std::int64_t>(values.NullCount());
+				array.buffers[0] = values.Validity().Words().data();
+			}
+		}
+
+		template <typename T> static const char* Format() {
+			if constexpr (std::is_same<T, Date>::value) {
+				return "tdD";
+			}
+			else if constexpr (std::is_integral<T>::value) {
+				constexpr const char* kSignedFormats[] = {"c", "s", "", "i", "", "", "", "l"};
+				constexpr const char* kUnsignedFormats[] = {"C", "S", "", "I", "", "", "", "L"};
+				static_assert(sizeof(T) <= 8, "Integers wider than 64 bits have no Arrow type");
+				return std::is_signed<T>::value ? kSignedFormats[sizeof(T) - 1] : kUnsignedFormats[sizeof(T) - 1];
+			}
+			else {
+				static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value, "Column type has no Arrow type");
+				return std::is_same<T, float>::value ? "f" : "g";
+			}
 		}
 
-		std::vector<std::tuple<ColumnTypes...>> elements_;
+		static void Initialize(std::unique_ptr<ArrayData> array_data, std::unique_ptr<SchemaData> schema_data, const char* const format,
+			const std::string& name, const std::size_t length, std::vector<const void*> buffers, ArrowArray& array, ArrowSchema& schema) {
+
+			schema_data->format = format;
+			schema_data->name = name;
+			for (auto& child : schema_data->children) {
+				schema_data->child_pointers.push_back(&child);
+			}
+			array_data->buffers = std::move(buffers);
+			for (auto& child : array_data->children) {
+				array_data->child_pointers.push_back(&child);
+			}
+
+			schema = ArrowSchema{};
+			schema.format = schema_data->format.c_str();
+			schema.name = schema_data->name.c_str();
+			schema.n_children = static_cast<std::int64_t>(schema_data->children.size());
+			schema.children = schema_data->child_pointers.data();
+			schema.dictionary = schema_data->dictionary.get();
+			schema.release = [](ArrowSchema* const released) {
+				delete static_cast<SchemaData*>(released->private_data);
+				released->release = nullptr;
+			};
+			schema.private_data = schema_data.release();
+
+			array = ArrowArray{};
+			array.length = static_cast<std::int64_t>(length);
+			array.n_buffers = static_cast<std::int64_t>(array_data->buffers.size());
+			array.n_children = static_cast<std::int64_t>(array_data->children.size());
+			array.buffers = array_data->buffers.data();
+			array.children = array_data->child_pointers.data();
+			array.dictionary = array_data->dictionary.get();
+			array.release = [](ArrowArray* const released) {
+				delete static_cast<ArrayData*>(released->private_data);
+				released->release = nullptr;
+			};
+			array.private_data = array_data.release();
+		}
 	};
 
-	template <typename T> class Csv<T> final : public CsvBase {
+	template <typename DialectType, typename... ColumnTypes>
+	void ExportArrow(const BasicCsv<DialectType, ColumnTypes...>& csv, ArrowArray* const array, ArrowSchema* const schema,
+		const std::vector<std::string>& names = {}) {
+
+		ArrowExporter::Export(csv, names, array, schema);
+	}
+
+	inline void ExportArrow(const DynamicCsv& csv, ArrowArray* const array, ArrowSchema* const schema) {
+		ArrowExporter::Export(csv, array, schema);
+	}
+
+#ifdef CSV_HAS_COROUTINES
+
+	template <typename T> class Generator {
 
 	public:
-		explicit Csv(const std::string_view data) : elements_{ParseData(data)} {}
+		struct promise_type {
+			const T* value = nullptr;
+			std::exception_ptr exception;
 
-		[[nodiscard]] const T& Get(const std::size_t row_index, const std::size_t column_index) const {
-			if (row_index >= elements_.size() || column_index >= elements_[row_index].size()) {
-				throw std::runtime_error{"Index out of bounds"};
+			Generator get_return_object() noexcept { return Generator{Handle::from_promise(*this)}; }
+			std::suspend_always initial_suspend() const noexcept { return {}; }
+			std::suspend_always final_suspend() const noexcept { return {}; }
+			std::suspend_always yield_value(const T& yielded) noexcept { value = std::addressof(yielded); return {}; }
+			void return_void() const noexcept {}
+			void unhandled_exception() noexcept { exception = std::current_exception(); }
+		};
+
+		using Handle = std::coroutine_handle<promise_type>;
+
+		class Iterator {
+
+		public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = T;
+			using difference_type = std::ptrdiff_t;
+
+			Iterator() noexcept = default;
+			explicit Iterator(const Handle handle) noexcept : handle_{handle} {}
+
+			[[nodiscard]] const T& operator*() const noexcept { return *handle_.promise().value; }
+			[[nodiscard]] const T* operator->() const noexcept { return handle_.promise().value; }
+
+			Iterator& operator++() {
+				Resume(handle_);
+				return *this;
+			}
+			void operator++(int) { ++*this; }
+
+			[[nodiscard]] bool operator==(std::default_sentinel_t) const noexcept { return !handle_ || handle_.done(); }
+
+		private:
+			Handle handle_;
+		};
+
+		explicit Generator(const Handle handle) noexcept : handle_{handle} {}
+		Generator(Generator&& other) noexcept : handle_{std::exchange(other.handle_, {})} {}
+		Generator& operator=(Generator&& other) noexcept {
+			if (this != &other) {
+				if (handle_) {
+					handle_.destroy();
+				}
+				handle_ = std::exchange(other.handle_, {});
+			}
+			return *this;
+		}
+		~Generator() {
+			if (handle_) {
+				handle_.destroy();
 			}
-			return elements_[row_index][column_index];
 		}
 
+		[[nodiscard]] Iterator begin() {
+			Resume(handle_);
+			return Iterator{handle_};
+		}
+		[[nodiscard]] std::default_sentinel_t end() const noexcept { return {}; }
+
 	private:
-		static std::vector<std::vector<T>> ParseData(const std::string_view data) {
-			const auto lines = Split(data, '\n');
-			std::vector<std::vector<T>> elements;
-			elements.reserve(lines.size());
+		static void Resume(const Handle handle) {
+			handle.resume();
+			if (handle.promise().exception) {
+				std::rethrow_exception(handle.promise().exception);
+			}
+		}
 
-			std::transform(std::cbegin(lines), std::cend(lines), std::back_inserter(elements),
-				[](const auto& line) { return ParseLine(line); });
+		Handle handle_;
+	};
 
-			return elements;
+	// Lazily parses one row per resumption; the source is read in blocks as records are consumed.
+	template <typename DialectType, typename... ColumnTypes>
+	Generator<std::tuple<ColumnTypes...>> Rows(BasicRowReader<DialectType, ColumnTypes...>& reader) {
+		for (std::tuple<ColumnTypes...> row; reader.Next(row);) {
+			co_yield row;
 		}
+	}
 
-		static std::vector<T> ParseLine(const std::string_view line) {
-			const auto tokens = Split(line, ',');
-			std::vector<T> values;
-			values.reserve(tokens.size());
-
-			std::transform(std::cbegin(tokens), std::cend(tokens), std::back_inserter(values),
-				[](const auto& token) { return ParseToken<T>(token); });
+	// Resumption never waits on the source itself: blocks are read ahead on a separate thread, so the next block is read
+	// while the rows of the current one are parsed and consumed.
+	template <typename... ColumnTypes>
+	Generator<std::tuple<ColumnTypes...>> Rows(InputSource& source, const std::size_t buffer_size = RecordReader<>::kDefaultBufferSize) {
+		ReadAheadSource read_ahead{source, buffer_size};
+		RowReader<ColumnTypes...> reader{read_ahead, buffer_size};
+		for (const auto& row : Rows(reader)) {
+			co_yield row;
+		}
+	}
 
-			return values;
+	template <typename... ColumnTypes>
+	Generator<std::tuple<ColumnTypes...>> Rows(std::istream& stream, const std::size_t buffer_size = RecordReader<>::kDefaultBufferSize) {
+		StreamSource source{stream};
+		for (const auto& row : Rows<ColumnTypes...>(source, buffer_size)) {
+			co_yield row;
 		}
+	}
 
-		std::vector<std::vector<T>> elements_;
-	};
+#endif
 }
@@ -2,6 +2,9 @@
 
 #include "catch.hpp"
 
+#include <filesystem>
+#include <numeric>
+
 #include "csv.hpp"
 
 using namespace csv;
@@ -36,6 +39,17 @@ TEST_CASE("CSV parsing with homogeneous data", "[csv]") {
 			REQUIRE_THROWS(csv.Get(0, 3));
 		}
 	}
+
+	SECTION("A record that fails to parse leaves an appended table unchanged") {
+		Csv<int32_t> csv{"1, 2\n"};
+		REQUIRE_THROWS(csv.Append("3, x\n5, 6\n"));
+		REQUIRE(csv.RowCount() == 1);
+
+		csv.Append("7, 8\n");
+		REQUIRE(csv.RowCount() == 2);
+		REQUIRE(csv[1].size() == 2);
+		REQUIRE(csv.Get(1, 0) == 7);
+	}
 }
 
 TEST_CASE("CSV parsing with heterogeneous data") {
@@ -111,4 +125,1451 @@ TEST_CASE("CSV parsing with heterogeneous data") {
 			REQUIRE_THROWS(csv.Get<double>(0, 4));
 		}
 	}
+
+	SECTION("A record that fails to parse leaves an appended table unchanged") {
+		Csv<std::string, std::optional<int32_t>, Dictionary, bool, int32_t> csv{"a, 1, x, true, 1\n"};
+		REQUIRE_THROWS(csv.Append("b, , y, false, 2\nc, 3, z, true, w\n"));
+		REQUIRE(csv.RowCount() == 1);
+		REQUIRE(csv.Column<0>().size() == 1);
+		REQUIRE(csv.Column<1>().size() == 1);
+		REQUIRE(csv.Column<1>().NullCount() == 0);
+		REQUIRE(csv.Column<1>().Validity().empty());
+		REQUIRE(csv.Column<2>().size() == 1);
+		REQUIRE(csv.Column<3>().size() == 1);
+		REQUIRE(csv.Column<4>().size() == 1);
+
+		csv.Append("d, , z, false, 4\n");
+		REQUIRE(csv.RowCount() == 2);
+		REQUIRE(csv.Get<std::string>(1, 0) == "d");
+		REQUIRE(csv.Get<std::optional<int32_t>>(1, 1) == std::nullopt);
+		REQUIRE(csv.Get<Dictionary>(1, 2) == "z");
+		REQUIRE(csv.Get<bool>(1, 3) == false);
+		REQUIRE(csv.Get<int32_t>(1, 4) == 4);
+	}
+}
+
+TEST_CASE("CSV iteration") {
+
+	SECTION("Iterating a homogeneous CSV visits each row as a contiguous span") {
+		const std::string data{"0, 1, 2\n3, 4\n5, 6, 7, 8"};
+		const Csv<int32_t> csv{data};
+
+		REQUIRE(csv.RowCount() == 3);
+		REQUIRE(csv[1].size() == 2);
+
+		int32_t expected = 0;
+		for (const auto row : csv) {
+			for (const auto value : row) {
+				REQUIRE(value == expected++);
+			}
+		}
+		REQUIRE(expected == 9);
+	}
+
+	SECTION("Iterating a heterogeneous CSV visits each row in order") {
+		const std::string data{"a, 3.141, 42, true\nb, 2.718, 0, false\nc, 1.618, 7, true"};
+		const Csv<char, double, int32_t, bool> csv{data};
+
+		REQUIRE(csv.RowCount() == 3);
+		REQUIRE(std::distance(csv.begin(), csv.end()) == 3);
+
+		auto row = csv.begin();
+		REQUIRE(row->Get<0>() == 'a');
+		REQUIRE((row + 2)->Get<2>() == 7);
+		REQUIRE(row[1].Get<char>(0) == 'b');
+		REQUIRE(std::count_if(csv.begin(), csv.end(), [](const auto& r) { return r.template Get<3>(); }) == 2);
+	}
+
+	SECTION("Column views are contiguous and work with standard algorithms") {
+		const std::string data{"a, 3.141, 42, true\nb, 2.718, 0, false\nc, 1.618, 7, true"};
+		const Csv<char, double, int32_t, bool> csv{data};
+
+		const auto integers = csv.Column<2>();
+		REQUIRE(integers.size() == 3);
+		REQUIRE(integers.data() + 2 == &integers[2]);
+		REQUIRE(std::accumulate(integers.begin(), integers.end(), 0) == 49);
+		REQUIRE(*std::max_element(csv.Column<1>().begin(), csv.Column<1>().end()) == Approx(3.141));
+	}
+
+	SECTION("Row ranges check bounds once for the whole range") {
+		const std::string data{"0, 1\n2, 3\n4, 5\n6, 7"};
+		const Csv<int64_t, int64_t> csv{data};
+
+		const auto rows = csv.Rows(1, 2);
+		REQUIRE(rows.size() == 2);
+		REQUIRE(rows.begin()->Get<0>() == 2);
+		REQUIRE((rows.end() - 1)->Get<1>() == 5);
+
+		REQUIRE_THROWS(csv.Rows(3, 2));
+		REQUIRE_THROWS(csv[4]);
+		REQUIRE_THROWS(csv.Column<0>().Subspan(2, 3));
+	}
+}
+
+TEST_CASE("CSV streaming") {
+
+	SECTION("Records which straddle buffer boundaries are reassembled") {
+		const std::string data{"alpha\n\nbeta, gamma\ndelta"};
+		BufferSource source{data};
+		RecordReader reader{source, 4};
+
+		std::vector<std::string> records;
+		for (std::string_view record; reader.Next(record);) {
+			records.emplace_back(record);
+		}
+
+		REQUIRE(records == std::vector<std::string>{"alpha", "beta, gamma", "delta"});
+	}
+
+	SECTION("Reading typed rows from a stream is correct") {
+		std::istringstream data{"a, 3.141, 42, true\nb, 2.718, 0, false\n"};
+		StreamSource source{data};
+		RowReader<char, double, int32_t, bool> reader{source, 8};
+
+		std::tuple<char, double, int32_t, bool> row;
+		REQUIRE(reader.Next(row));
+		REQUIRE(std::get<0>(row) == 'a');
+		REQUIRE(std::get<2>(row) == 42);
+		REQUIRE(reader.Next(row));
+		REQUIRE(std::get<1>(row) == Approx(2.718));
+		REQUIRE(std::get<3>(row) == false);
+		REQUIRE_FALSE(reader.Next(row));
+	}
+
+#ifdef CSV_HAS_COROUTINES
+	SECTION("A row generator lazily yields each row") {
+		std::istringstream data{"0, 1\n2, 3\n4, 5"};
+
+		int64_t expected = 0;
+		for (const auto& [first, second] : Rows<int64_t, int64_t>(data, 4)) {
+			REQUIRE(first == expected++);
+			REQUIRE(second == expected++);
+		}
+		REQUIRE(expected == 6);
+	}
+
+	SECTION("A row generator reads its source on another thread") {
+		struct ThreadRecordingSource final : InputSource {
+			explicit ThreadRecordingSource(const std::string_view data) : buffer{data} {}
+			std::size_t Read(char* const destination, const std::size_t size) override {
+				reader = std::this_thread::get_id();
+				return buffer.Read(destination, size);
+			}
+			BufferSource buffer;
+			std::thread::id reader;
+		} source{"1\n2\n3\n"};
+
+		std::int64_t total = 0;
+		for (const auto& [value] : Rows<std::int64_t>(source, 2)) {
+			total += value;
+		}
+		REQUIRE(total == 6);
+		REQUIRE(source.reader != std::this_thread::get_id());
+	}
+#endif
+}
+
+TEST_CASE("CSV read-ahead parsing") {
+
+	SECTION("Reading ahead on a separate thread preserves the input") {
+		std::string data;
+		for (auto i = 0; i < 1000; ++i) {
+			data += std::to_string(i) + ", " + std::to_string(i * 2) + '\n';
+		}
+		BufferSource buffer{data};
+		ReadAheadSource source{buffer, 7};
+		const Csv<int32_t, int64_t> csv{source};
+
+		REQUIRE(csv.RowCount() == 1000);
+		for (const auto row : csv) {
+			REQUIRE(row.Get<1>() == 2 * row.Get<0>());
+		}
+	}
+
+	SECTION("Parsing a file with read-ahead is correct") {
+		const auto path = (std::filesystem::temp_directory_path() / "csv_test_read_ahead.csv").string();
+		std::ofstream{path} << "0, 1, 2\n3, 4, 5\n6, 7, 8";
+
+		FileSource file{path};
+		ReadAheadSource source{file, 5};
+		const Csv<int32_t> csv{source};
+		std::filesystem::remove(path);
+
+		for (auto i = 0; i < 3; ++i) {
+			for (auto j = 0; j < 3; ++j) {
+				REQUIRE(csv.Get(i, j) == 3 * i + j);
+			}
+		}
+	}
+
+	SECTION("Data read before a failure is returned before the error") {
+		struct FailingSource final : InputSource {
+			std::size_t Read(char* const buffer, const std::size_t size) override {
+				if (reads_++ != 0) {
+					throw std::runtime_error{"Disk failure"};
+				}
+				std::fill_n(buffer, size, 'x');
+				return size;
+			}
+			int reads_ = 0;
+		} failing;
+
+		ReadAheadSource source{failing, 4};
+		std::this_thread::sleep_for(std::chrono::milliseconds{10});
+		char buffer[4];
+		REQUIRE(source.Read(buffer, sizeof(buffer)) == 4);
+		REQUIRE(std::string_view{buffer, 4} == "xxxx");
+		REQUIRE_THROWS_WITH(source.Read(buffer, sizeof(buffer)), "Disk failure");
+	}
+
+	SECTION("Opening a file which does not exist throws an exception") {
+		REQUIRE_THROWS(FileSource{"csv_test_missing_file.csv"});
+	}
+}
+
+#ifdef CSV_HAS_POSIX_IO
+TEST_CASE("CSV file input sources") {
+	const auto path = (std::filesystem::temp_directory_path() / "csv_test_file_sources.csv").string();
+	std::string data;
+	for (auto i = 0; i < 5000; ++i) {
+		data += std::to_string(i) + ", " + std::to_string(i * 3) + '\n';
+	}
+	std::ofstream{path, std::ios::binary} << data;
+
+	const auto require_rows = [](InputSource& source) {
+		const Csv<int32_t, int32_t> csv{source};
+		REQUIRE(csv.RowCount() == 5000);
+		for (const auto row : csv) {
+			REQUIRE(row.Get<1>() == 3 * row.Get<0>());
+		}
+	};
+
+	SECTION("Reading a file with pread is correct") {
+		PreadSource source{path};
+		require_rows(source);
+	}
+
+	SECTION("Memory-mapping a file exposes its contents") {
+		const MappedFile file{path};
+		REQUIRE(file.Data() == data);
+	}
+
+	SECTION("Opening a file selects an available backend") {
+		const auto source = OpenFile(path, {4096, 3, false});
+		require_rows(*source);
+	}
+
+	SECTION("Direct reads fall back to buffered reads where the filesystem refuses them") {
+		const auto source = OpenFile(path, {4096, 3, true});
+		require_rows(*source);
+		REQUIRE_THROWS_AS(OpenFile("csv_test_missing_file.csv", {4096, 3, true}), std::system_error);
+	}
+
+#ifdef CSV_HAS_IO_URING
+	SECTION("Reading a file with io_uring is correct across many small blocks") {
+		try {
+			IoUringSource source{path, 4096, 3};
+			require_rows(source);
+		}
+		catch (const IoUringUnavailable&) {
+			WARN("io_uring is unavailable on this system");
+		}
+	}
+#endif
+
+	std::filesystem::remove(path);
+}
+#endif
+
+#ifdef CSV_HAS_ZLIB
+TEST_CASE("CSV compressed input") {
+
+	const auto compress = [](const std::string& data) {
+		z_stream stream{};
+		REQUIRE(deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+		std::string compressed(deflateBound(&stream, static_cast<uLong>(data.size())), '\0');
+		stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+		stream.avail_in = static_cast<uInt>(data.size());
+		stream.next_out = reinterpret_cast<Bytef*>(compressed.data());
+		stream.avail_out = static_cast<uInt>(compressed.size());
+		REQUIRE(deflate(&stream, Z_FINISH) == Z_STREAM_END);
+		compressed.resize(stream.total_out);
+		deflateEnd(&stream);
+		return compressed;
+	};
+
+	std::string data;
+	for (auto i = 0; i < 2000; ++i) {
+		data += std::to_string(i) + ", " + std::to_string(i % 7) + '\n';
+	}
+
+	SECTION("Parsing gzip-compressed input is correct") {
+		const auto compressed = compress(data);
+		BufferSource buffer{compressed};
+		GzipSource source{buffer, 64, 2};
+		const Csv<int32_t, int32_t> csv{source};
+
+		REQUIRE(csv.RowCount() == 2000);
+		for (const auto row : csv) {
+			REQUIRE(row.Get<1>() == row.Get<0>() % 7);
+		}
+	}
+
+	SECTION("Concatenated gzip members are decompressed in sequence") {
+		const auto compressed = compress("0, 1\n") + compress("2, 3\n");
+		BufferSource buffer{compressed};
+		GzipSource source{buffer, 3};
+		const Csv<int32_t> csv{source};
+
+		REQUIRE(csv.RowCount() == 2);
+		REQUIRE(csv.Get(1, 1) == 3);
+	}
+
+	SECTION("Truncated gzip input throws an exception") {
+		const auto compressed = compress(data);
+		BufferSource buffer{std::string_view{compressed}.substr(0, compressed.size() / 2)};
+		GzipSource source{buffer};
+		REQUIRE_THROWS(Csv<int32_t, int32_t>{source});
+	}
+}
+#endif
+
+TEST_CASE("CSV dialects") {
+
+	SECTION("Tab-separated values are parsed with the TSV dialect") {
+		const std::string data{"a\t1\t2.5\nb\t2\t3.5"};
+		const BasicCsv<TsvDialect, char, int32_t, double> csv{data};
+
+		REQUIRE(csv.Get<char>(1, 0) == 'b');
+		REQUIRE(csv.Get<int32_t>(1, 1) == 2);
+		REQUIRE(csv.Get<double>(0, 2) == Approx(2.5));
+	}
+
+	SECTION("Pipe-delimited values with CRLF line endings are parsed") {
+		const std::string data{"1|2|3\r\n4|5|6\r\n"};
+		const BasicCsv<Dialect<'|', '"', '"', false, LineEnding::kCrLf>, int32_t> csv{data};
+
+		REQUIRE(csv.RowCount() == 2);
+		REQUIRE(csv.Get(1, 2) == 6);
+	}
+
+	SECTION("Quoted fields may contain delimiters, escaped quotes and record separators") {
+		const std::string data{"\"a, b\", 1\n\"say \"\"hi\"\"\", 2\n\"multi\nline\", 3"};
+		const Csv<std::string, int32_t> csv{data};
+
+		REQUIRE(csv.RowCount() == 3);
+		REQUIRE(csv.Get<std::string>(0, 0) == "a, b");
+		REQUIRE(csv.Get<std::string>(1, 0) == "say \"hi\"");
+		REQUIRE(csv.Get<std::string>(2, 0) == "multi\nline");
+		REQUIRE(csv.Get<int32_t>(2, 1) == 3);
+	}
+
+	SECTION("A custom escape character escapes the next character inside quotes") {
+		const std::string data{"'it\\'s', 1"};
+		const BasicCsv<Dialect<',', '\'', '\\'>, std::string, int32_t> csv{data};
+
+		REQUIRE(csv.Get<std::string>(0, 0) == "it's");
+	}
+
+	SECTION("Quotes inside unquoted fields are literal") {
+		const Csv<int, std::string> csv{"1,5\" tall\n2,x\n3,y\n"};
+
+		REQUIRE(csv.RowCount() == 3);
+		REQUIRE(csv.Get<std::string>(0, 1) == "5\" tall");
+		REQUIRE(csv.Get<std::string>(2, 1) == "y");
+
+		const Csv<std::string, std::string> quoted{"a\"b, \"c\nd\"\ne, f"};
+		REQUIRE(quoted.RowCount() == 2);
+		REQUIRE(quoted.Get<std::string>(0, 1) == "c\nd");
+	}
+
+	SECTION("Quoted records which straddle buffer boundaries are reassembled") {
+		const std::string data{"\"x\ny\", 1\n\"z\", 2"};
+		BufferSource source{data};
+		RowReader<std::string, int32_t> reader{source, 3};
+
+		std::tuple<std::string, int32_t> row;
+		REQUIRE(reader.Next(row));
+		REQUIRE(std::get<0>(row) == "x\ny");
+		REQUIRE(reader.Next(row));
+		REQUIRE(std::get<1>(row) == 2);
+		REQUIRE_FALSE(reader.Next(row));
+	}
+
+	SECTION("A dialect chosen at runtime is equivalent to its compile-time counterpart") {
+		const std::string data{"1;2\r\n3;4\r\n"};
+		RuntimeDialect dialect;
+		dialect.delimiter = ';';
+		dialect.line_ending = LineEnding::kAny;
+		const BasicCsv<RuntimeDialect, int32_t, int32_t> csv{data, dialect};
+
+		REQUIRE(csv.RowCount() == 2);
+		REQUIRE(csv.Get<int32_t>(1, 1) == 4);
+	}
+
+	SECTION("Error handling") {
+
+		SECTION("An unterminated quoted field throws an exception") {
+			REQUIRE_THROWS(Csv<std::string>{"\"abc"});
+		}
+
+		SECTION("A record with too few fields throws an exception") {
+			REQUIRE_THROWS(Csv<int32_t, int32_t>{"1, 2\n3"});
+		}
+
+		SECTION("A field which cannot be converted throws an exception") {
+			REQUIRE_THROWS(Csv<int32_t, bool>{"1, maybe"});
+		}
+
+		SECTION("A plus sign may not precede another sign") {
+			REQUIRE(Csv<int32_t>{"+5"}.Get(0, 0) == 5);
+			REQUIRE_THROWS_WITH(Csv<int32_t>{"+-5"}, "Invalid value: +-5");
+			REQUIRE_THROWS(Csv<double>{"++1.5"});
+			REQUIRE(Sniff("1\n+-5\n+3\n").columns[0].type == ColumnType::kString);
+		}
+	}
+}
+
+TEST_CASE("CSV null values") {
+
+	SECTION("Empty fields in optional columns are null and do not shift later fields") {
+		const std::string data{"1,,3\n4, 5, 6\n7, 8"};
+		const Csv<int32_t, std::optional<int32_t>, std::optional<double>> csv{data};
+
+		REQUIRE(csv.RowCount() == 3);
+		REQUIRE_FALSE(csv.Get<std::optional<int32_t>>(0, 1).has_value());
+		REQUIRE(csv.Get<std::optional<double>>(0, 2) == Approx(3.0));
+		REQUIRE(csv.Get<std::optional<int32_t>>(1, 1) == 5);
+		REQUIRE_FALSE(csv[2].Get<2>().has_value());
+	}
+
+	SECTION("Nullable columns track missing values in a validity bitmap") {
+		const std::string data{"1, 1\n2, \n3, 3\n4, "};
+		const Csv<std::optional<int32_t>, std::optional<int32_t>> csv{data};
+
+		const auto& complete = csv.Column<0>();
+		REQUIRE(complete.NullCount() == 0);
+		REQUIRE(complete.Validity().empty());
+		REQUIRE(std::accumulate(complete.Values().begin(), complete.Values().end(), 0) == 10);
+
+		const auto& sparse = csv.Column<1>();
+		REQUIRE(sparse.NullCount() == 2);
+		REQUIRE(sparse.Validity().size() == 4);
+		REQUIRE(sparse.Validity().Count() == 2);
+		REQUIRE(sparse.IsValid(0));
+		REQUIRE_FALSE(sparse.IsValid(3));
+		REQUIRE(sparse[2] == 3);
+	}
+
+	SECTION("Reading optional values from a stream is correct") {
+		std::istringstream data{"a,\n,2"};
+		StreamSource source{data};
+		RowReader<std::optional<char>, std::optional<int32_t>> reader{source};
+
+		std::tuple<std::optional<char>, std::optional<int32_t>> row;
+		REQUIRE(reader.Next(row));
+		REQUIRE(std::get<0>(row) == 'a');
+		REQUIRE_FALSE(std::get<1>(row).has_value());
+		REQUIRE(reader.Next(row));
+		REQUIRE_FALSE(std::get<0>(row).has_value());
+		REQUIRE(std::get<1>(row) == 2);
+	}
+
+	SECTION("An empty field in a column which is not optional throws an exception") {
+		REQUIRE_THROWS(Csv<int32_t, int32_t, int32_t>{"1,,3"});
+	}
+}
+
+TEST_CASE("CSV dictionary-encoded columns") {
+
+	SECTION("Repeated values are interned once and stored as 8-bit codes") {
+		const std::string data{"US, 1\nDE, 2\nUS, 3\nFR, 4\nDE, 5"};
+		const Csv<Dictionary, int32_t> csv{data};
+
+		const auto& countries = csv.Column<0>();
+		REQUIRE(countries.DistinctCount() == 3);
+		REQUIRE(countries.CodeWidth() == 1);
+		REQUIRE(csv.Get<Dictionary>(2, 0) == "US");
+		REQUIRE(csv[4].Get<0>() == "DE");
+		REQUIRE(countries.CodeAt(0) == countries.CodeAt(2));
+	}
+
+	SECTION("Equality filters run on integer codes") {
+		const std::string data{"US\nDE\nUS\nFR\nDE\nUS"};
+		const Csv<Dictionary, Dictionary> csv{data};
+
+		const auto& countries = csv.Column<0>();
+		const auto code = countries.Find("US");
+		REQUIRE(code.has_value());
+		REQUIRE_FALSE(countries.Find("JP").has_value());
+
+		const auto matches = countries.VisitCodes([&](const auto codes) {
+			return std::count(codes.begin(), codes.end(), *code);
+		});
+		REQUIRE(matches == 3);
+	}
+
+	SECTION("Codes are widened as the number of distinct values grows") {
+		std::string data;
+		for (auto i = 0; i < 70000; ++i) {
+			data += "value" + std::to_string(i) + ", " + std::to_string(i) + '\n';
+		}
+		const Csv<Dictionary, int32_t> csv{data};
+
+		const auto& values = csv.Column<0>();
+		REQUIRE(values.size() == 70000);
+		REQUIRE(values.DistinctCount() == 70000);
+		REQUIRE(values.CodeWidth() == 4);
+		REQUIRE(values[0] == "value0");
+		REQUIRE(values[300] == "value300");
+		REQUIRE(values[69999] == "value69999");
+	}
+
+	SECTION("Nullable dictionary columns are supported") {
+		const Csv<std::optional<Dictionary>, int32_t> csv{"a, 1\n, 2\na, 3"};
+
+		REQUIRE(csv.Get<std::optional<Dictionary>>(0, 0) == std::optional<std::string_view>{"a"});
+		REQUIRE_FALSE(csv.Get<std::optional<Dictionary>>(1, 0).has_value());
+	}
+}
+
+TEST_CASE("CSV boolean columns") {
+
+	SECTION("Boolean variants are recognized regardless of letter case") {
+		const std::string data{"true, FALSE, T, f, 1, 0, True, faLse"};
+		const Csv<bool> csv{data};
+		const std::vector<bool> expected{true, false, true, false, true, false, true, false};
+
+		REQUIRE(std::vector<bool>(csv[0].begin(), csv[0].end()) == expected);
+	}
+
+	SECTION("Unrecognized boolean values throw an exception") {
+		REQUIRE_THROWS(Csv<bool, bool>{"true, yes"});
+		REQUIRE_THROWS(Csv<bool, bool>{"true, tru"});
+		REQUIRE_THROWS(Csv<bool, bool>{"true, 2"});
+	}
+
+	SECTION("Boolean columns are packed into bits and counted with popcount") {
+		std::string data;
+		for (auto i = 0; i < 200; ++i) {
+			data += std::to_string(i) + ", " + (i % 3 == 0 ? "true" : "false") + ", " + (i % 2 == 0 ? "t" : "f") + '\n';
+		}
+		const Csv<int32_t, bool, bool> csv{data};
+
+		const auto& multiples_of_three = csv.Column<1>();
+		REQUIRE(multiples_of_three.size() == 200);
+		REQUIRE(multiples_of_three.Words().size() == 4);
+		REQUIRE(multiples_of_three.Count() == 67);
+		REQUIRE(csv.Get<bool>(3, 1));
+		REQUIRE_FALSE(csv[4].Get<1>());
+
+		const auto multiples_of_six = csv.Column<1>() & csv.Column<2>();
+		std::vector<std::size_t> rows;
+		multiples_of_six.ForEachSet([&](const auto row) { rows.push_back(row); });
+
+		REQUIRE(rows.size() == multiples_of_six.Count());
+		REQUIRE(rows.size() == 34);
+		REQUIRE(std::all_of(rows.begin(), rows.end(), [](const auto row) { return row % 6 == 0; }));
+	}
+
+	SECTION("Nullable boolean columns store values and validity as bitmaps") {
+		const Csv<int32_t, std::optional<bool>> csv{"1, true\n2,\n3, false"};
+
+		const auto& flags = csv.Column<1>();
+		REQUIRE(flags.NullCount() == 1);
+		REQUIRE(flags.Values().Count() == 1);
+		REQUIRE(flags[0] == true);
+		REQUIRE_FALSE(flags[1].has_value());
+	}
+}
+
+TEST_CASE("CSV schema inference") {
+
+	SECTION("The narrowest type of each column is inferred") {
+		const std::string data{"1, 3000000000, 1.5, true, 2024-02-29, abc\n2, 4, 2, false, 1999-12-31, def"};
+		const auto schema = Sniff(data);
+
+		REQUIRE(schema.dialect.delimiter == ',');
+		REQUIRE_FALSE(schema.has_header);
+		REQUIRE(schema.columns.size() == 6);
+		REQUIRE(schema.columns[0].type == ColumnType::kInt32);
+		REQUIRE(schema.columns[1].type == ColumnType::kInt64);
+		REQUIRE(schema.columns[2].type == ColumnType::kDouble);
+		REQUIRE(schema.columns[3].type == ColumnType::kBool);
+		REQUIRE(schema.columns[4].type == ColumnType::kDate);
+		REQUIRE(schema.columns[5].type == ColumnType::kString);
+		REQUIRE(schema.columns[0].name == "column0");
+	}
+
+	SECTION("The delimiter, line ending and header are detected") {
+		const std::string data{"id\tname\tscore\r\n1\ta\t0.5\r\n2\tb\t\r\n3\tc\t1.5\r\n"};
+		const auto schema = Sniff(data);
+
+		REQUIRE(schema.dialect.delimiter == '\t');
+		REQUIRE(schema.dialect.line_ending == LineEnding::kCrLf);
+		REQUIRE(schema.has_header);
+		REQUIRE(schema.columns.size() == 3);
+		REQUIRE(schema.columns[0].name == "id");
+		REQUIRE(schema.columns[2].name == "score");
+		REQUIRE(schema.columns[0].type == ColumnType::kInt32);
+		REQUIRE(schema.columns[1].type == ColumnType::kString);
+		REQUIRE(schema.columns[2].type == ColumnType::kDouble);
+		REQUIRE(schema.columns[2].nullable);
+		REQUIRE_FALSE(schema.columns[0].nullable);
+	}
+
+	SECTION("Sampling strided blocks finds values beyond the first rows") {
+		std::string data{"a|b\n"};
+		for (auto i = 0; i < 1000; ++i) {
+			data += std::to_string(i) + '|' + std::to_string(i) + (i < 500 ? "" : ".5") + '\n';
+		}
+
+		SniffOptions options;
+		options.sample_rows = 20;
+		REQUIRE(Sniff(data, options).columns[1].type == ColumnType::kInt32);
+
+		options.sample_blocks = 4;
+		const auto schema = Sniff(data, options);
+		REQUIRE(schema.dialect.delimiter == '|');
+		REQUIRE(schema.has_header);
+		REQUIRE(schema.columns[1].type == ColumnType::kDouble);
+	}
+
+	SECTION("Headers are detected over columns which only hold strings") {
+		const auto schema = Sniff("name,city\nalice,paris\nbob,rome\n");
+		REQUIRE(schema.has_header);
+		REQUIRE(schema.columns[1].name == "city");
+
+		const DynamicCsv csv{"name,city\nalice,paris\nbob,rome\n", schema};
+		REQUIRE(csv.RowCount() == 2);
+		REQUIRE(csv.Get<std::string>(0, 0) == "alice");
+
+		REQUIRE_FALSE(Sniff("paris,fr\nrome,it\nparis,fr\n").has_header);
+		REQUIRE_FALSE(Sniff("id,name\n1,alice\n2,bob\n").columns[1].name == "column1");
+		REQUIRE_FALSE(Sniff("1,alice\n2,bob\n3,carol\n").has_header);
+	}
+
+	SECTION("Dates are parsed as days since the epoch") {
+		const Csv<Date, Date> csv{"1970-01-01, 2000-03-01"};
+		REQUIRE(csv.Get<Date>(0, 0).days_since_epoch == 0);
+		REQUIRE(csv.Get<Date>(0, 1) == Date::FromCivil(2000, 3, 1));
+		REQUIRE(Date::FromCivil(2000, 3, 1).days_since_epoch == 11017);
+		REQUIRE_THROWS(Csv<Date, Date>{"2023-02-29, 2023-01-01"});
+	}
+}
+
+TEST_CASE("CSV runtime schemas") {
+
+	SECTION("Columns are parsed into the types of an inferred schema") {
+		const std::string data{"id,name,score,active,joined\n1,ann,0.5,true,2024-01-02\n2,bob,,false,2023-12-31\n3,cy,1.5,true,2020-02-29\n"};
+		const DynamicCsv csv{data, Sniff(data)};
+
+		REQUIRE(csv.RowCount() == 3);
+		REQUIRE(csv.ColumnCount() == 5);
+		REQUIRE(csv.Get<std::int32_t>(2, 0) == 3);
+		REQUIRE(csv.Get<std::string>(1, csv.ColumnIndex("name")) == "bob");
+		REQUIRE(csv.Get<double>(0, 2) == 0.5);
+		REQUIRE_FALSE(csv.Get<double>(1, 2));
+		REQUIRE(csv.Get<bool>(1, 3) == false);
+		REQUIRE(csv.Get<Date>(2, 4) == Date::FromCivil(2020, 2, 29));
+
+		const auto& scores = csv.Column<double>(2);
+		REQUIRE(scores.NullCount() == 1);
+		REQUIRE(scores.Values()[2] == 1.5);
+
+		std::int32_t sum = 0;
+		for (const auto& row : csv) {
+			sum += *row.Get<std::int32_t>(0);
+		}
+		REQUIRE(sum == 6);
+	}
+
+	SECTION("Columns are parsed into the types of an explicit schema") {
+		Schema schema;
+		schema.dialect.delimiter = ';';
+		schema.columns = {{"key", ColumnType::kString, false}, {"value", ColumnType::kInt64, true}};
+
+		const DynamicCsv csv{"a;1\nb;\n;3000000000", schema};
+		REQUIRE(csv.RowCount() == 3);
+		REQUIRE(csv.Get<std::string>(2, 0) == "");
+		REQUIRE_FALSE(csv.Get<std::int64_t>(1, 1));
+		REQUIRE(csv[2].Get<std::int64_t>(1) == 3000000000);
+		REQUIRE(csv.GetSchema().columns[1].name == "value");
+	}
+
+	SECTION("Type mismatches and invalid values are reported") {
+		Schema schema;
+		schema.columns = {{"a", ColumnType::kInt32, false}};
+
+		const DynamicCsv csv{"1\n2", schema};
+		REQUIRE_THROWS_WITH(csv.Get<double>(0, 0), "Column type mismatch");
+		REQUIRE_THROWS(csv.Get<std::int32_t>(2, 0));
+		REQUIRE_THROWS(csv.Get<std::int32_t>(0, 1));
+		REQUIRE_THROWS_WITH(csv.ColumnIndex("b"), "Unknown column: b");
+		REQUIRE_THROWS(DynamicCsv{"1\nx", schema});
+
+		schema.columns.push_back({"b", ColumnType::kDouble, false});
+		REQUIRE_THROWS_WITH(DynamicCsv("1,\n", schema), "Missing value");
+	}
+}
+
+TEST_CASE("CSV hash indexes") {
+
+	SECTION("Unique keys map to their rows") {
+		const Csv<std::int32_t, double> csv{"7, 0.5\n3, 1.5\n9, 2.5"};
+		const HashIndex<std::int32_t> index{csv.Column<0>(), true};
+
+		REQUIRE(index.DistinctCount() == 3);
+		REQUIRE(index.Find(3) == std::optional<std::size_t>{1});
+		REQUIRE(csv.Get<double>(*index.Find(9), 1) == 2.5);
+		REQUIRE_FALSE(index.Find(4));
+		REQUIRE_FALSE(index.Contains(0));
+		REQUIRE(index.EqualRange(4).empty());
+	}
+
+	SECTION("Repeated keys map to every row in order") {
+		const Csv<std::string, Dictionary> csv{"a, x\nb, y\na, x\nc, x\na, z"};
+		const HashIndex<std::string_view> names{csv.Column<0>()};
+		const auto rows = names.EqualRange("a");
+
+		REQUIRE(names.DistinctCount() == 3);
+		REQUIRE(std::vector<std::size_t>(rows.begin(), rows.end()) == std::vector<std::size_t>{0, 2, 4});
+		REQUIRE(names.Find("c") == std::optional<std::size_t>{3});
+
+		const HashIndex<std::string> codes{csv.Column<1>()};
+		REQUIRE(codes.EqualRange("x").size() == 3);
+		REQUIRE_THROWS_WITH(HashIndex<std::string_view>(csv.Column<0>(), true), "Duplicate key");
+	}
+
+	SECTION("Null keys are not indexed") {
+		const Csv<std::optional<std::int64_t>, char> csv{"1, a\n, b\n1, c\n2, d"};
+		const HashIndex<std::int64_t> index{csv.Column<0>()};
+
+		REQUIRE(index.DistinctCount() == 2);
+		REQUIRE(index.EqualRange(1).size() == 2);
+		REQUIRE(index.EqualRange(0).empty());
+	}
+
+	SECTION("Strided keys are found after the table grows") {
+		std::vector<std::int64_t> keys;
+		for (std::int64_t i = 0; i < 20000; ++i) {
+			keys.push_back(i * 1024);
+		}
+		const HashIndex<std::int64_t> index{keys, true};
+
+		REQUIRE(index.DistinctCount() == keys.size());
+		for (std::size_t row = 0; row < keys.size(); row += 97) {
+			REQUIRE(index.Find(keys[row]) == std::optional<std::size_t>{row});
+		}
+		REQUIRE_FALSE(index.Find(1023));
+	}
+
+	SECTION("Date and decimal keys are hashed by the library") {
+		const Csv<Date, Decimal<6, 2>> csv{"2024-03-01, 1.50\n2023-12-31, 2.00\n2024-03-01, 1.5"};
+		const HashIndex<Date> days{csv.Column<0>()};
+
+		REQUIRE(days.DistinctCount() == 2);
+		REQUIRE(days.EqualRange(Date::FromCivil(2024, 3, 1)).size() == 2);
+		REQUIRE(days.Find(Date::FromCivil(2023, 12, 31)) == std::optional<std::size_t>{1});
+
+		const HashIndex<Decimal<6, 2>> prices{csv.Column<1>()};
+		REQUIRE(prices.EqualRange(*Decimal<6, 2>::Parse("1.5")).size() == 2);
+	}
+}
+
+TEST_CASE("CSV sorted indexes") {
+
+	SECTION("Range queries return rows in key order") {
+		const Csv<std::int64_t, std::string> csv{"30, c\n-10, a\n20, b\n30, d\n50, e"};
+		const SortedIndex<std::int64_t> index{csv.Column<0>()};
+
+		const auto sorted = index.Rows();
+		REQUIRE(std::vector<std::size_t>(sorted.begin(), sorted.end()) == std::vector<std::size_t>{1, 2, 0, 3, 4});
+
+		const auto range = index.Range(0, 50);
+		REQUIRE(std::vector<std::size_t>(range.begin(), range.end()) == std::vector<std::size_t>{2, 0, 3});
+		REQUIRE(index.EqualRange(30).size() == 2);
+		REQUIRE(index.Range(60, 100).empty());
+		REQUIRE(index.Range(50, 0).empty());
+		REQUIRE(index.LowerBound(30) == 2);
+		REQUIRE(index.UpperBound(30) == 4);
+		REQUIRE(csv.Get<std::string>(index.Rows(index.UpperBound(30), index.size())[0], 1) == "e");
+	}
+
+	SECTION("Keys without a radix order are merge sorted") {
+		std::vector<double> keys;
+		std::vector<std::string> names;
+		for (auto i = 0; i < 100000; ++i) {
+			keys.push_back((i * 7919 % 100000) / 4.0);
+			names.push_back(std::to_string(i % 1000));
+		}
+
+		const SortedIndex<double> index{keys};
+		REQUIRE(std::is_sorted(index.SortedKeys().begin(), index.SortedKeys().end()));
+		REQUIRE(index.Range(10.0, 20.0).size() == 40);
+
+		const SortedIndex<std::string_view> by_name{names};
+		REQUIRE(by_name.EqualRange("999").size() == 100);
+		const auto rows = by_name.EqualRange("5");
+		REQUIRE(std::is_sorted(rows.begin(), rows.end()));
+	}
+
+	SECTION("Radix sorted rows are stable and ordered by sign") {
+		std::vector<std::int32_t> keys;
+		for (auto i = 0; i < 50000; ++i) {
+			keys.push_back((i % 2 == 0 ? -1 : 1) * (i * 31 % 1000));
+		}
+
+		const SortedIndex<std::int32_t> index{keys};
+		const auto rows = index.Rows();
+		for (std::size_t i = 1; i < rows.size(); ++i) {
+			REQUIRE((keys[rows[i - 1]] < keys[rows[i]] || (keys[rows[i - 1]] == keys[rows[i]] && rows[i - 1] < rows[i])));
+		}
+	}
+
+	SECTION("Null keys are left out and dates are ordered") {
+		const Csv<std::optional<Date>, char> csv{"2024-03-01, a\n, b\n2023-12-31, c\n2024-01-15, d"};
+		const SortedIndex<Date> index{csv.Column<0>()};
+
+		REQUIRE(index.size() == 3);
+		const auto range = index.Range(Date::FromCivil(2024, 1, 1), Date::FromCivil(2025, 1, 1));
+		REQUIRE(std::vector<std::size_t>(range.begin(), range.end()) == std::vector<std::size_t>{3, 0});
+	}
+
+	SECTION("Indexes are saved and loaded") {
+		const Csv<std::int32_t, char> csv{"3, a\n1, b\n2, c"};
+		const SortedIndex<std::int32_t> index{csv.Column<0>()};
+
+		std::stringstream stream;
+		index.Save(stream);
+		const auto loaded = SortedIndex<std::int32_t>::Load(stream, csv.Column<0>());
+		REQUIRE(loaded.size() == 3);
+		REQUIRE(loaded.SourceRowCount() == 3);
+		REQUIRE(loaded.EqualRange(1)[0] == 1);
+		REQUIRE(loaded.Range(2, 4).size() == 2);
+
+		std::stringstream truncated{stream.str().substr(0, 40)};
+		REQUIRE_THROWS_WITH(SortedIndex<std::int32_t>::Load(truncated, csv.Column<0>()), "Invalid index file");
+
+		stream.seekg(0);
+		REQUIRE_THROWS_WITH(SortedIndex<std::int64_t>::Load(stream, csv.Column<0>()), "Invalid index file");
+
+		const Csv<std::int32_t, char> appended{"3, a\n1, b\n2, c\n4, d"};
+		stream.seekg(0);
+		REQUIRE_THROWS_WITH(SortedIndex<std::int32_t>::Load(stream, appended.Column<0>()), "Stale index file");
+
+		const Csv<std::int32_t, char> edited{"3, a\n5, b\n2, c"};
+		stream.seekg(0);
+		REQUIRE_THROWS_WITH(SortedIndex<std::int32_t>::Load(stream, edited.Column<0>()), "Stale index file");
+	}
+
+	SECTION("Corrupt sizes fail without allocating for them") {
+		const std::vector<std::int32_t> keys{5, 4};
+		std::stringstream stream;
+		SortedIndex<std::int32_t>{keys}.Save(stream);
+
+		auto data = stream.str();
+		const std::uint64_t huge = std::uint64_t{1} << 60;
+		std::memcpy(&data[32], &huge, sizeof huge);
+		std::stringstream corrupt{data};
+		REQUIRE_THROWS_WITH(SortedIndex<std::int32_t>::Load(corrupt, keys), "Invalid index file");
+
+		data = stream.str();
+		data[data.size() - 8] = 9;
+		std::stringstream out_of_range{data};
+		REQUIRE_THROWS_WITH(SortedIndex<std::int32_t>::Load(out_of_range, keys), "Invalid index file");
+	}
+}
+
+TEST_CASE("CSV sorting") {
+
+	SECTION("Rows are ordered by several columns") {
+		Csv<Dictionary, std::int64_t, double, bool> csv{"b, 2, 0.5, t\na, 3, 1.5, f\nb, 1, 2.5, t\na, 3, 3.5, t\nc, 0, 4.5, f"};
+
+		const auto order = csv.SortedOrder<0, 1>();
+		REQUIRE(order == std::vector<std::size_t>{1, 3, 2, 0, 4});
+		REQUIRE(csv.SortedOrder<3, 2>() == std::vector<std::size_t>{1, 4, 0, 2, 3});
+
+		csv.Sort<0, 1>();
+		REQUIRE(csv.Get<Dictionary>(0, 0) == "a");
+		REQUIRE(csv.Get<double>(1, 2) == 3.5);
+		REQUIRE(csv.Get<std::int64_t>(2, 1) == 1);
+		REQUIRE(csv.Get<bool>(4, 3) == false);
+		REQUIRE(csv.Column<0>().DistinctCount() == 3);
+	}
+
+	SECTION("Null values order first") {
+		Csv<std::optional<std::string>, std::optional<std::int32_t>> csv{"b, 1\n, 2\na, \nb, 0"};
+
+		REQUIRE(csv.SortedOrder<0, 1>() == std::vector<std::size_t>{1, 2, 3, 0});
+		csv.Sort<1>();
+		REQUIRE_FALSE(csv.Get<std::optional<std::int32_t>>(0, 1));
+		REQUIRE(csv.Get<std::optional<std::string>>(0, 0) == "a");
+		REQUIRE(csv.Get<std::optional<std::int32_t>>(3, 1) == 2);
+		REQUIRE(csv.Column<1>().NullCount() == 1);
+	}
+
+	SECTION("Large tables are sorted stably") {
+		std::string data;
+		for (auto i = 0; i < 40000; ++i) {
+			data += std::to_string(i % 7 - 3) + ", " + std::to_string((i * 7919) % 1000 / 8.0) + ", " + std::to_string(i) + '\n';
+		}
+		Csv<std::int32_t, double, std::int32_t> csv{data};
+		csv.Sort<0, 1>();
+
+		for (std::size_t row = 1; row < csv.RowCount(); ++row) {
+			const auto previous = std::tuple{csv.Get<std::int32_t>(row - 1, 0), csv.Get<double>(row - 1, 1), csv.Get<std::int32_t>(row - 1, 2)};
+			const auto current = std::tuple{csv.Get<std::int32_t>(row, 0), csv.Get<double>(row, 1), csv.Get<std::int32_t>(row, 2)};
+			REQUIRE(previous < current);
+		}
+	}
+
+	SECTION("Runtime-typed tables are sorted by column index") {
+		Schema schema;
+		schema.columns = {{"name", ColumnType::kString, false}, {"day", ColumnType::kDate, true}};
+		DynamicCsv csv{"x, 2024-01-02\ny, \nx, 2023-05-06\n", schema};
+
+		REQUIRE(csv.SortedOrder({0, 1}) == std::vector<std::size_t>{2, 0, 1});
+		csv.Sort({1});
+		REQUIRE(csv.Get<std::string>(0, 0) == "y");
+		REQUIRE(csv.Get<Date>(1, 1) == Date::FromCivil(2023, 5, 6));
+		REQUIRE_THROWS(csv.SortedOrder({2}));
+	}
+}
+
+TEST_CASE("CSV group-by aggregation") {
+
+	SECTION("Rows are grouped by one or more key columns") {
+		const Csv<Dictionary, std::string, std::int32_t, std::optional<double>> csv{
+			"east, a, 1, 0.5\nwest, b, 2, \neast, a, 3, 1.5\neast, c, 4, \nwest, b, 5, 2.5"};
+
+		const auto regions = Aggregate<GroupKey<0>, Count, Sum<2>, Mean<3>, Min<1>, Max<2>>(csv);
+		REQUIRE(regions.size() == 2);
+		REQUIRE(std::get<0>(regions[0].key) == "east");
+		REQUIRE(regions[0].values == std::tuple{std::size_t{3}, std::int64_t{8}, std::optional<double>{1.0}, std::optional<std::string>{"a"}, std::optional<std::int32_t>{4}});
+		REQUIRE(std::get<1>(regions[1].values) == 7);
+		REQUIRE(std::get<2>(regions[1].values) == 2.5);
+
+		const auto pairs = Aggregate<GroupKey<0, 1>, Count>(csv);
+		REQUIRE(pairs.size() == 3);
+		REQUIRE(pairs[2].key == std::tuple{std::string{"east"}, std::string{"c"}});
+
+		const auto totals = Aggregate<GroupKey<>, Count, Sum<3>>(csv);
+		REQUIRE(totals.size() == 1);
+		REQUIRE(std::get<1>(totals[0].values) == 4.5);
+	}
+
+	SECTION("Null keys form their own group") {
+		const Csv<std::optional<std::int64_t>, bool> csv{"1, t\n, f\n1, f\n, t\n2, t"};
+		const auto groups = Aggregate<GroupKey<0>, Count, Sum<1>>(csv);
+
+		REQUIRE(groups.size() == 3);
+		REQUIRE_FALSE(std::get<0>(groups[1].key));
+		REQUIRE(std::get<0>(groups[1].values) == 2);
+		REQUIRE(std::get<1>(groups[0].values) == 1);
+	}
+
+	SECTION("Partial tables merge to the same result as streaming") {
+		std::string data;
+		for (auto i = 0; i < 50000; ++i) {
+			data += 'k';
+			data += std::to_string(i * 7 % 101) + ", " + std::to_string(i % 13) + ", " + std::to_string(i) + '\n';
+		}
+
+		const Csv<Dictionary, std::int32_t, std::int64_t> csv{data};
+		const auto groups = Aggregate<GroupKey<0, 1>, Count, Sum<2>, Max<2>>(csv);
+
+		std::istringstream stream{data};
+		StreamSource source{stream};
+		RowReader<Dictionary, std::int32_t, std::int64_t> reader{source};
+		GroupBy<std::tuple<Dictionary, std::int32_t, std::int64_t>, GroupKey<0, 1>, Count, Sum<2>, Max<2>> group_by;
+		for (std::tuple<Dictionary, std::int32_t, std::int64_t> row; reader.Next(row);) {
+			group_by.Add(row);
+		}
+
+		REQUIRE(groups.size() == 101 * 13);
+		REQUIRE(group_by.GroupCount() == groups.size());
+
+		const auto streamed = group_by.Groups();
+		std::size_t count = 0;
+		std::int64_t sum = 0;
+		for (std::size_t group = 0; group < groups.size(); ++group) {
+			REQUIRE(groups[group].key == streamed[group].key);
+			REQUIRE(groups[group].values == streamed[group].values);
+			count += std::get<0>(groups[group].values);
+			sum += std::get<1>(groups[group].values);
+		}
+		REQUIRE(count == 50000);
+		REQUIRE(sum == std::int64_t{49999} * 50000 / 2);
+	}
+}
+
+TEST_CASE("CSV hash joins") {
+
+	const Csv<std::optional<std::int32_t>, std::string, double> orders{"1, ann, 9.5\n2, bob, 3.0\n1, ann, 1.5\n4, dan, 2.0\n, eve, 7.0\n3, cy, 4.0"};
+	const Csv<std::optional<std::int32_t>, Dictionary> customers{"1, gold\n3, silver\n5, bronze\n1, platinum\n, none"};
+
+	SECTION("Inner joins pair every matching row") {
+		const auto pairs = HashJoin<0, 0>(orders, customers);
+
+		REQUIRE(pairs.left_rows == std::vector<std::size_t>{0, 0, 2, 2, 5});
+		REQUIRE(pairs.right_rows == std::vector<std::size_t>{0, 3, 0, 3, 1});
+
+		const auto swapped = HashJoin<0, 0>(customers, orders);
+		REQUIRE(swapped.left_rows == std::vector<std::size_t>{0, 0, 1, 3, 3});
+		REQUIRE(swapped.right_rows == std::vector<std::size_t>{0, 2, 5, 0, 2});
+	}
+
+	SECTION("Left joins keep unmatched rows") {
+		const auto pairs = HashJoin<0, 0>(orders, customers, JoinType::kLeft);
+		REQUIRE(pairs.left_rows == std::vector<std::size_t>{0, 0, 1, 2, 2, 3, 4, 5});
+		REQUIRE(pairs.right_rows[2] == JoinedRows::kNoMatch);
+		REQUIRE(pairs.right_rows[6] == JoinedRows::kNoMatch);
+
+		const auto swapped = HashJoin<0, 0>(customers, orders, JoinType::kLeft);
+		REQUIRE(swapped.left_rows == std::vector<std::size_t>{0, 0, 1, 2, 3, 3, 4});
+		REQUIRE(swapped.right_rows[3] == JoinedRows::kNoMatch);
+		REQUIRE(swapped.right_rows[6] == JoinedRows::kNoMatch);
+	}
+
+	SECTION("Joined rows project into new columns") {
+		const auto pairs = HashJoin<0, 0>(orders, customers, JoinType::kLeft);
+		const auto [names, totals] = Project<1, 2>(orders, pairs.left_rows);
+		const auto [tiers] = Project<1>(customers, pairs.right_rows);
+
+		REQUIRE(names.size() == 8);
+		REQUIRE(names[1] == "ann");
+		REQUIRE(totals[7] == 4.0);
+		REQUIRE(tiers[1] == "platinum");
+		REQUIRE(tiers[4] == "platinum");
+		REQUIRE_FALSE(tiers[2]);
+		REQUIRE(tiers.NullCount() == 3);
+	}
+
+	SECTION("Date keys are joined") {
+		const Csv<Date, std::int32_t> visits{"2024-01-02, 1\n2024-01-03, 2\n2024-01-02, 3"};
+		const Csv<Date, std::string> holidays{"2024-01-02, bank holiday\n2024-12-25, christmas"};
+		const auto pairs = HashJoin<0, 0>(visits, holidays);
+
+		REQUIRE(pairs.left_rows == std::vector<std::size_t>{0, 2});
+		REQUIRE(pairs.right_rows == std::vector<std::size_t>{0, 0});
+	}
+
+	SECTION("String keys are joined in parallel slices") {
+		std::string facts, dimensions;
+		for (auto i = 0; i < 60000; ++i) {
+			facts += 'k';
+			facts += std::to_string(i % 1500) + ", " + std::to_string(i) + '\n';
+		}
+		for (auto i = 0; i < 1000; ++i) {
+			dimensions += 'k';
+			dimensions += std::to_string(i) + ", " + std::to_string(i * 2) + '\n';
+		}
+
+		const Csv<std::string, std::int64_t> fact_table{facts};
+		const Csv<std::string, std::int64_t> dimension_table{dimensions};
+		const auto pairs = HashJoin<0, 0>(fact_table, dimension_table);
+
+		REQUIRE(pairs.left_rows.size() == 40000);
+		REQUIRE(std::is_sorted(pairs.left_rows.begin(), pairs.left_rows.end()));
+		for (std::size_t pair = 0; pair < pairs.left_rows.size(); pair += 101) {
+			REQUIRE(fact_table.Get<std::string>(pairs.left_rows[pair], 0) == dimension_table.Get<std::string>(pairs.right_rows[pair], 0));
+		}
+		REQUIRE(HashJoin<0, 0>(dimension_table, fact_table, JoinType::kLeft).left_rows.size() == 40000);
+	}
+}
+
+TEST_CASE("CSV Arrow export") {
+
+	SECTION("Columns are exported without copying their buffers") {
+		const Csv<std::int32_t, double, bool, std::string, Dictionary, std::optional<std::int64_t>, Date> csv{
+			"1, 0.5, t, ab, x, 7, 2024-01-02\n2, 1.5, f, , y, , 2024-01-03\n3, 2.5, t, cde, x, 9, 2024-01-04"};
+
+		ArrowArray array;
+		ArrowSchema schema;
+		ExportArrow(csv, &array, &schema, {"id", "score"});
+
+		REQUIRE(std::string{schema.format} == "+s");
+		REQUIRE(schema.n_children == 7);
+		REQUIRE(array.length == 3);
+		REQUIRE(array.n_children == 7);
+		REQUIRE(std::string{schema.children[0]->name} == "id");
+		REQUIRE(std::string{schema.children[2]->name}.empty());
+
+		std::vector<std::string> formats;
+		for (auto child = 0; child < schema.n_children; ++child) {
+			formats.emplace_back(schema.children[child]->format);
+		}
+		REQUIRE(formats == std::vector<std::string>{"i", "g", "b", "U", "C", "l", "tdD"});
+
+		REQUIRE(array.children[0]->buffers[1] == csv.Column<0>().data());
+		REQUIRE(array.children[1]->buffers[1] == csv.Column<1>().data());
+		REQUIRE(array.children[2]->buffers[1] == csv.Column<2>().Words().data());
+		REQUIRE(static_cast<const std::uint64_t*>(array.children[2]->buffers[1])[0] == 0b101);
+
+		const auto* const offsets = static_cast<const std::int64_t*>(array.children[3]->buffers[1]);
+		const auto* const bytes = static_cast<const char*>(array.children[3]->buffers[2]);
+		REQUIRE(std::string(bytes + offsets[2], static_cast<std::size_t>(offsets[3] - offsets[2])) == "cde");
+		REQUIRE(offsets[1] == offsets[2]);
+
+		REQUIRE(schema.children[4]->dictionary != nullptr);
+		REQUIRE(std::string{schema.children[4]->dictionary->format} == "u");
+		REQUIRE(array.children[4]->dictionary->length == 2);
+		REQUIRE(static_cast<const std::uint8_t*>(array.children[4]->buffers[1])[2] == 0);
+
+		REQUIRE(schema.children[5]->flags == ARROW_FLAG_NULLABLE);
+		REQUIRE(array.children[5]->null_count == 1);
+		REQUIRE(static_cast<const std::uint64_t*>(array.children[5]->buffers[0])[0] == 0b101);
+		REQUIRE(array.children[0]->buffers[0] == nullptr);
+
+		REQUIRE(static_cast<const std::int32_t*>(array.children[6]->buffers[1])[0] == Date::FromCivil(2024, 1, 2).days_since_epoch);
+
+		// consumers may move children out before releasing the parent
+		ArrowArray moved = *array.children[3];
+		array.children[3]->release = nullptr;
+		array.release(&array);
+		schema.release(&schema);
+		REQUIRE(array.release == nullptr);
+		REQUIRE(schema.release == nullptr);
+		REQUIRE(moved.length == 3);
+		moved.release(&moved);
+		REQUIRE(moved.release == nullptr);
+	}
+
+	SECTION("Runtime-typed tables are exported with their schema names") {
+		const std::string data{"id,name,when\n1,a,2024-01-01\n2,,2024-01-02\n"};
+		DynamicCsv csv{data, Sniff(data)};
+
+		ArrowArray array;
+		ArrowSchema schema;
+		ExportArrow(csv, &array, &schema);
+
+		REQUIRE(schema.n_children == 3);
+		REQUIRE(std::string{schema.children[1]->name} == "name");
+		REQUIRE(std::string{schema.children[1]->format} == "U");
+		REQUIRE(std::string{schema.children[2]->format} == "tdD");
+		REQUIRE(array.children[0]->buffers[1] == csv.Column<std::int32_t>(0).Values().data());
+
+		array.release(&array);
+		schema.release(&schema);
+	}
+}
+
+#ifdef CSV_HAS_POSIX_IO
+TEST_CASE("CSV following appended files") {
+	const auto path = (std::filesystem::temp_directory_path() / "csv_test_follow.csv").string();
+	std::ofstream{path, std::ios::binary} << "1, a\n2, b\n3, c";
+	const auto append = [&path](const std::string& data) { std::ofstream{path, std::ios::binary | std::ios::app} << data; };
+
+	CsvFollower<std::int32_t, std::string> follower{path};
+
+	SECTION("Only appended records are parsed") {
+		REQUIRE(follower.Table().RowCount() == 2);
+		REQUIRE(follower.Offset() == 10);
+		REQUIRE(follower.Refresh() == 0);
+
+		append("d\n4, \"e\nf\"");
+		REQUIRE(follower.Refresh() == 1);
+		REQUIRE(follower.Table().Get<std::string>(2, 1) == "cd");
+		REQUIRE(follower.Offset() == 16);
+
+		append("\n");
+		REQUIRE(follower.Refresh() == 1);
+		REQUIRE(follower.Table().Get<std::string>(3, 1) == "e\nf");
+		REQUIRE(follower.RebuildCount() == 0);
+	}
+
+	SECTION("Truncated files are parsed again") {
+		std::ofstream{path, std::ios::binary} << "9, z\n";
+		REQUIRE(follower.Refresh() == 1);
+		REQUIRE(follower.RebuildCount() == 1);
+		REQUIRE(follower.Table().Get<std::int32_t>(0, 0) == 9);
+	}
+
+	SECTION("Files rewritten past their old size are parsed again") {
+		std::ofstream{path, std::ios::binary} << "7, x\n8, y\n9, z\n";
+		REQUIRE(follower.Refresh() == 3);
+		REQUIRE(follower.RebuildCount() == 1);
+		REQUIRE(follower.Table().Get<std::int32_t>(0, 0) == 7);
+	}
+
+	SECTION("Records that fail to parse are not appended twice") {
+		append("\nx, d\n");
+		REQUIRE_THROWS(follower.Refresh());
+		REQUIRE_THROWS(follower.Refresh());
+		REQUIRE(follower.Table().RowCount() == 2);
+		REQUIRE(follower.Offset() == 10);
+	}
+
+	SECTION("Rotated files are parsed again") {
+		std::filesystem::rename(path, path + ".1");
+		REQUIRE(follower.Refresh() == 0);
+
+		std::ofstream{path, std::ios::binary} << "5, v\n6, w\n7, x\n8, y\n";
+		REQUIRE(follower.Refresh() == 4);
+		REQUIRE(follower.RebuildCount() == 1);
+		REQUIRE(follower.Table().Get<std::int32_t>(0, 0) == 5);
+		std::filesystem::remove(path + ".1");
+	}
+
+#ifdef CSV_HAS_INOTIFY
+	SECTION("Appends are signalled by inotify") {
+		REQUIRE_FALSE(follower.WaitForChange(std::chrono::milliseconds{0}));
+		append("\n");
+		REQUIRE(follower.WaitForChange(std::chrono::milliseconds{1000}));
+		REQUIRE(follower.Refresh() == 1);
+		REQUIRE_FALSE(follower.WaitForChange(std::chrono::milliseconds{0}));
+	}
+#endif
+
+	std::filesystem::remove(path);
+}
+#endif
+
+#ifdef CSV_HAS_POSIX_IO
+TEST_CASE("CSV paged tables") {
+	const auto path = (std::filesystem::temp_directory_path() / "csv_test_paged.csv").string();
+	{
+		std::ofstream file{path, std::ios::binary};
+		for (auto i = 0; i < 1000; ++i) {
+			file << i << ',' << (i == 150 ? "\"line\nbreak\"" : "name" + std::to_string(i)) << "\n\n";
+		}
+	}
+
+	SECTION("Rows are read across blocks") {
+		PagedCsv<std::int32_t, std::string> csv{path, std::numeric_limits<std::size_t>::max(), 100};
+		REQUIRE(csv.RowCount() == 1000);
+		REQUIRE(csv.BlockCount() == 10);
+		REQUIRE(csv.Get<std::int32_t>(999, 0) == 999);
+		REQUIRE(csv.Get<std::string>(150, 1) == "line\nbreak");
+		REQUIRE(csv.Get<std::string>(151, 1) == "name151");
+		REQUIRE(csv.Block(9)->RowCount() == 100);
+		REQUIRE(csv.Hits() == 2);
+		REQUIRE(csv.Misses() == 2);
+		REQUIRE_THROWS_WITH(csv.Get<std::int32_t>(1000, 0), "Index out of bounds");
+	}
+
+	SECTION("Least recently used blocks are evicted") {
+		const auto block_bytes = PagedCsv<std::int32_t, std::string>{path, 0, 100}.Block(0)->MemoryUsage();
+		PagedCsv<std::int32_t, std::string> csv{path, block_bytes * 5 / 2, 100};
+
+		for (std::size_t row = 0; row < csv.RowCount(); ++row) {
+			REQUIRE(csv.Get<std::int32_t>(row, 0) == static_cast<std::int32_t>(row));
+		}
+		REQUIRE(csv.Misses() == 10);
+		REQUIRE(csv.CachedBytes() <= csv.MemoryBudget());
+
+		REQUIRE(csv.Get<std::int32_t>(850, 0) == 850);
+		REQUIRE(csv.Get<std::int32_t>(50, 0) == 50);
+		REQUIRE(csv.Misses() == 11);
+
+		const auto block = csv.Block(3);
+		REQUIRE(csv.Get<std::int32_t>(0, 0) == 0);
+		REQUIRE(csv.Get<std::int32_t>(999, 0) == 999);
+		REQUIRE(block->Get<std::string>(0, 1) == "name300");
+	}
+
+	std::filesystem::remove(path);
+}
+#endif
+
+TEST_CASE("CSV parse statistics") {
+	const std::string data{"1,a,2020-01-01\n\n2,\"b\nc\",2020-01-02\n3,d,2020-01-03\n"};
+
+	SECTION("Heterogeneous tables record each column") {
+		ParseStatistics statistics;
+		const Csv<std::int32_t, std::string, Date> csv{data, {}, statistics};
+		REQUIRE(csv.RowCount() == 3);
+		REQUIRE(statistics.BytesScanned() == data.size());
+		REQUIRE(statistics.Rows() == 3);
+		REQUIRE(statistics.Fields() == 9);
+		REQUIRE(statistics.Columns().size() == 3);
+		REQUIRE(statistics.Columns()[1].fields == 3);
+		REQUIRE(statistics.CapacityGrowths() > 0);
+		REQUIRE(statistics.GrownBytes() >= statistics.Columns()[1].grown_bytes);
+		REQUIRE(statistics.GrownBytes() == csv.MemoryUsage());
+		REQUIRE(statistics.ConversionTime() >= statistics.Columns()[0].conversion_time);
+	}
+
+	SECTION("Homogeneous tables record each field position") {
+		ParseStatistics statistics;
+		std::istringstream stream{"1,2\n3,4,5\n"};
+		StreamSource source{stream};
+		const Csv<std::int32_t> csv{source, {}, statistics};
+		REQUIRE(csv.RowCount() == 2);
+		REQUIRE(statistics.Rows() == 2);
+		REQUIRE(statistics.Fields() == 5);
+		REQUIRE(statistics.Columns().size() == 3);
+		REQUIRE(statistics.Columns()[2].fields == 1);
+		REQUIRE(statistics.GrownBytes() >= 5 * sizeof(std::int32_t));
+	}
+}
+
+TEST_CASE("CSV Chrome tracing") {
+	std::ostringstream trace;
+
+	SECTION("Phases, reads and milestones are traced") {
+		std::string data;
+		for (auto i = 0; i < 70000; ++i) {
+			data += std::to_string(i) + '\n';
+		}
+		std::istringstream stream{data};
+		StreamSource source{stream};
+		{
+			ChromeTracer tracer{trace};
+			REQUIRE(Csv<std::int32_t>{source, {}, tracer}.RowCount() == 70000);
+		}
+		const auto events = trace.str();
+		REQUIRE(events.rfind("{\"traceEvents\":[\n{\"name\":\"parse\",\"cat\":\"csv\",\"ph\":\"B\"", 0) == 0);
+		REQUIRE(events.find("{\"name\":\"read\",\"cat\":\"csv\",\"ph\":\"E\"") != std::string::npos);
+		REQUIRE(events.find("\"ph\":\"C\"") != std::string::npos);
+		REQUIRE(events.find("\"args\":{\"rows\":65536}") != std::string::npos);
+		REQUIRE(events.find("\"name\":\"parse\",\"cat\":\"csv\",\"ph\":\"E\"") != std::string::npos);
+		REQUIRE(events.substr(events.size() - 3) == "]}\n");
+	}
+
+	SECTION("Errors are traced before they propagate") {
+		{
+			ChromeTracer tracer{trace};
+			Csv<std::int32_t, std::int32_t> csv{"1,2\n", {}, tracer};
+			REQUIRE_THROWS(csv.Append("3,4\n5,\"x\n\"\n", true, tracer));
+		}
+		const auto events = trace.str();
+		REQUIRE(events.find("\"name\":\"append\",\"cat\":\"csv\",\"ph\":\"B\"") != std::string::npos);
+		REQUIRE(events.find("\"ph\":\"i\"") != std::string::npos);
+		REQUIRE(events.find("\"args\":{\"row\":2,\"message\":\"Invalid value: x\\u000a\"}") != std::string::npos);
+		REQUIRE(events.find("\"name\":\"append\",\"cat\":\"csv\",\"ph\":\"E\"") != std::string::npos);
+	}
+}
+
+TEST_CASE("CSV UTF-8 validation") {
+	SECTION("Well-formed text is accepted") {
+		REQUIRE(FindInvalidUtf8("") == std::string_view::npos);
+		REQUIRE(FindInvalidUtf8("plain ASCII text longer than one word") == std::string_view::npos);
+		REQUIRE(FindInvalidUtf8("caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80 \xEF\xBF\xBF \xF4\x8F\xBF\xBF") == std::string_view::npos);
+	}
+
+	SECTION("The first ill-formed sequence is reported") {
+		REQUIRE(FindInvalidUtf8("abcdefghij\x80") == 10);
+		REQUIRE(FindInvalidUtf8("\xC0\x80") == 0);
+		REQUIRE(FindInvalidUtf8("a\xE0\x9F\xBF") == 1);
+		REQUIRE(FindInvalidUtf8("ab\xED\xA0\x80") == 2);
+		REQUIRE(FindInvalidUtf8("\xF4\x90\x80\x80") == 0);
+		REQUIRE(FindInvalidUtf8("\xF5\x80\x80\x80") == 0);
+		REQUIRE(FindInvalidUtf8("ok \xE2\x82") == 3);
+		REQUIRE(FindInvalidUtf8("\xE2\x82\x41") == 0);
+	}
+
+	SECTION("Validating dialects report the offset in the input") {
+		const std::string data{"1,ok\n2,caf\xC3\xA9\n3,b\xFF" "d\n"};
+		REQUIRE(Csv<std::int32_t, std::string>{data}.RowCount() == 3);
+		REQUIRE_THROWS_WITH((BasicCsv<Utf8CsvDialect, std::int32_t, std::string>{data}), "Invalid UTF-8 at byte 16");
+
+		std::string rows;
+		for (auto i = 0; i < 100; ++i) {
+			rows += "1,\xC3\xA9\n";
+		}
+		rows += "2,\xC3\n";
+		BufferSource source{rows};
+		BasicRowReader<Utf8CsvDialect, std::int32_t, std::string> reader{source, 16};
+		std::tuple<std::int32_t, std::string> row;
+		try {
+			while (reader.Next(row)) {
+			}
+			FAIL("Expected a UTF-8 error");
+		}
+		catch (const Utf8Error& error) {
+			REQUIRE(error.Offset() == 502);
+		}
+
+		BasicCsv<Utf8CsvDialect, std::int32_t, std::string> csv{"1,a\n"};
+		REQUIRE_THROWS_WITH(csv.Append("2,b\n3,\xE0\x80\n"), "Invalid UTF-8 at byte 6");
+	}
+
+	SECTION("Byte order marks are skipped") {
+		const std::string data{"\xEF\xBB\xBF" "1,a\n2,b\n"};
+		REQUIRE(HasUtf8Bom(data));
+		const BasicCsv<Utf8CsvDialect, std::int32_t, std::string> csv{data};
+		REQUIRE(csv.RowCount() == 2);
+		REQUIRE(csv.Get<std::int32_t>(0, 0) == 1);
+
+		std::istringstream stream{data};
+		StreamSource source{stream};
+		RecordReader reader{source, 1};
+		std::string_view record;
+		REQUIRE(reader.Next(record));
+		REQUIRE(record == "1,a");
+		REQUIRE(reader.SkippedBom());
+
+		const auto schema = Sniff("\xEF\xBB\xBF" "id,name\n1,a\n2,b\n");
+		REQUIRE(schema.has_header);
+		REQUIRE(schema.columns[0].name == "id");
+	}
+}
+
+TEST_CASE("CSV decimals") {
+	using Price = Decimal<10, 2>;
+
+	SECTION("Values are parsed exactly") {
+		REQUIRE(Price::Parse("12.34")->units == 1234);
+		REQUIRE(Price::Parse("-0.5")->units == -50);
+		REQUIRE(Price::Parse("+7")->units == 700);
+		REQUIRE(Price::Parse(".25")->units == 25);
+		REQUIRE(Price::Parse("1.2500")->units == 125);
+		REQUIRE(Price::Parse("00012345678.90")->units == 1234567890);
+		REQUIRE_FALSE(Price::Parse("123456789.00"));
+		REQUIRE_FALSE(Price::Parse("1.234"));
+		REQUIRE_FALSE(Price::Parse("1e3"));
+		REQUIRE_FALSE(Price::Parse("-"));
+		REQUIRE_FALSE(Price::Parse("."));
+		REQUIRE_FALSE(Price::Parse("1.2.3"));
+		REQUIRE(Decimal<3, 0>::Parse("999")->units == 999);
+		REQUIRE_FALSE(Decimal<3, 0>::Parse("1000"));
+	}
+
+	SECTION("Values are written back unchanged") {
+		for (const auto text : {"0.00", "12.34", "-0.05", "99999999.99", "-12345678.90"}) {
+			REQUIRE(Price::Parse(text)->ToString() == text);
+		}
+		REQUIRE(Decimal<5, 0>::Parse("-120")->ToString() == "-120");
+		std::ostringstream stream;
+		stream << *Price::Parse("3.5");
+		REQUIRE(stream.str() == "3.50");
+		REQUIRE(static_cast<double>(*Price::Parse("0.25")) == 0.25);
+	}
+
+	SECTION("Decimal columns are summed exactly") {
+		const Csv<Dictionary, Price, std::optional<Decimal<4, 3>>> csv{"a, 0.10, 1.5\nb, 0.20,\na, 0.30, 0.001\nb, -1.00, 2"};
+		REQUIRE(csv.Get<Price>(2, 1) == *Price::Parse("0.3"));
+		REQUIRE_THROWS_WITH((Csv<Price>{"1.005"}), "Invalid value: 1.005");
+
+		const auto groups = Aggregate<GroupKey<0>, Sum<1>, Sum<2>, Mean<1>, Max<1>>(csv);
+		REQUIRE(groups.size() == 2);
+		REQUIRE(std::get<0>(groups[0].values).ToString() == "0.40");
+		REQUIRE(std::get<1>(groups[0].values).ToString() == "1.501");
+		REQUIRE(std::get<0>(groups[1].values).ToString() == "-0.80");
+		REQUIRE(std::get<2>(groups[1].values) == Approx(-0.4));
+		REQUIRE(std::get<3>(groups[0].values) == Price::Parse("0.30"));
+
+		const auto by_price = Aggregate<GroupKey<1>, Count>(csv);
+		REQUIRE(by_price.size() == 4);
+
+		Csv<std::int32_t, Price> sorted{"1, 0.10\n2, 0.20\n3, 0.30\n4, -1.00"};
+		sorted.Sort<1>();
+		REQUIRE(sorted.Get<std::int32_t>(0, 0) == 4);
+		REQUIRE(sorted.Get<Price>(3, 1).ToString() == "0.30");
+	}
+
+#if defined(__SIZEOF_INT128__)
+	SECTION("Wide decimals are stored in 128 bits") {
+		using Wide = Decimal<38, 10>;
+		static_assert(sizeof(Wide::Units) == 16);
+		const auto text = "-9999999999999999999999999999.9999999999";
+		REQUIRE(Wide::Parse(text)->ToString() == text);
+		REQUIRE(Wide::Parse("0.0000000001")->units == 1);
+
+		const Csv<std::int32_t, Wide> csv{"1, 12345678901234567890.5\n2, 0.25"};
+		REQUIRE(std::get<0>(Aggregate<GroupKey<>, Sum<1>>(csv)[0].values).ToString() == "12345678901234567890.7500000000");
+	}
+#endif
 }